@@ -0,0 +1,183 @@
+#include <algorithm>
+
+#include "bignum.hpp"
+
+using namespace std;
+
+typedef vector<uint32_t> limbs;
+
+// =============================================================================
+// magnitudes
+// =============================================================================
+
+static void trim(limbs& a) {
+  while (!a.empty() && !a.back()) a.pop_back();
+}
+
+static int compare_mag(const limbs& a, const limbs& b) {
+  if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+  for (int i = int(a.size())-1; 0 <= i; i--) {
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+static limbs add_mag(const limbs& a, const limbs& b) {
+  limbs c(max(a.size(),b.size())+1);
+  uint64_t carry = 0;
+  for (int i = 0; i < c.size(); i++) {
+    carry += uint64_t(i < a.size() ? a[i] : 0)+(i < b.size() ? b[i] : 0);
+    c[i] = uint32_t(carry);
+    carry >>= 32;
+  }
+  trim(c);
+  return c;
+}
+
+// a >= b
+static limbs sub_mag(const limbs& a, const limbs& b) {
+  limbs c(a.size());
+  int64_t borrow = 0;
+  for (int i = 0; i < c.size(); i++) {
+    borrow += int64_t(a[i])-(i < b.size() ? b[i] : 0);
+    c[i] = uint32_t(borrow);
+    borrow = borrow < 0 ? -1 : 0;
+  }
+  trim(c);
+  return c;
+}
+
+static limbs mul_mag(const limbs& a, const limbs& b) {
+  limbs c(a.size()+b.size());
+  for (int i = 0; i < a.size(); i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < b.size(); j++) {
+      carry += uint64_t(a[i])*b[j]+c[i+j];
+      c[i+j] = uint32_t(carry);
+      carry >>= 32;
+    }
+    c[i+b.size()] = uint32_t(carry);
+  }
+  trim(c);
+  return c;
+}
+
+// quotient of a by a single limb d, and the remainder in r
+static limbs div_limb(const limbs& a, uint32_t d, uint32_t& r) {
+  limbs q(a.size());
+  uint64_t rem = 0;
+  for (int i = int(a.size())-1; 0 <= i; i--) {
+    rem = rem<<32 | a[i];
+    q[i] = uint32_t(rem/d);
+    rem %= d;
+  }
+  r = uint32_t(rem);
+  trim(q);
+  return q;
+}
+
+// binary long division, b != 0
+static limbs div_mag(const limbs& a, const limbs& b) {
+  uint32_t r;
+  if (b.size() == 1) return div_limb(a,b[0],r);
+  limbs q(a.size()), rem;
+  for (int i = int(a.size())*32-1; 0 <= i; i--) {
+    uint32_t carry = a[i/32]>>(i%32) & 1; // rem = rem*2+bit
+    for (int j = 0; j < rem.size(); j++) {
+      uint32_t next = rem[j]>>31;
+      rem[j] = rem[j]<<1 | carry;
+      carry = next;
+    }
+    if (carry) rem.push_back(carry);
+    if (compare_mag(rem,b) >= 0) {
+      rem = sub_mag(rem,b);
+      q[i/32] |= 1u<<(i%32);
+    }
+  }
+  trim(q);
+  return q;
+}
+
+// =============================================================================
+// signed numbers
+// =============================================================================
+
+bignum::bignum(int64_t v) : neg(v < 0) {
+  uint64_t u = neg ? -uint64_t(v) : uint64_t(v);
+  for (; u; u >>= 32) mag.push_back(uint32_t(u));
+}
+
+bignum bignum::parse(const string& s) {
+  bignum a;
+  for (int i = (s[0] == '-'); i < s.size(); i++) {
+    a.mag = add_mag(mul_mag(a.mag,limbs(1,10)),limbs(1,s[i]-'0'));
+  }
+  a.neg = (s[0] == '-' && !a.zero());
+  return a;
+}
+
+bool bignum::to_int64(int64_t& v) const {
+  if (mag.size() > 2) return false;
+  uint64_t u = 0;
+  for (int i = int(mag.size())-1; 0 <= i; i--) u = u<<32 | mag[i];
+  if (u > (neg ? uint64_t(1)<<63 : (uint64_t(1)<<63)-1)) return false;
+  v = neg ? int64_t(-u) : int64_t(u);
+  return true;
+}
+
+double bignum::to_double() const {
+  double d = 0;
+  for (int i = int(mag.size())-1; 0 <= i; i--) d = d*4294967296.0+mag[i];
+  return neg ? -d : d;
+}
+
+string bignum::str() const {
+  if (zero()) return "0";
+  string s;
+  limbs a = mag;
+  while (!a.empty()) {
+    uint32_t r;
+    a = div_limb(a,1000000000,r);
+    for (int i = 0; i < 9 && (r || !a.empty()); i++, r /= 10) s += '0'+r%10;
+  }
+  if (neg) s += '-';
+  reverse(s.begin(),s.end());
+  return s;
+}
+
+int compare(const bignum& a, const bignum& b) {
+  if (a.neg != b.neg) return a.neg ? -1 : 1;
+  int c = compare_mag(a.mag,b.mag);
+  return a.neg ? -c : c;
+}
+
+bignum operator+(const bignum& a, const bignum& b) {
+  bignum c;
+  if (a.neg == b.neg) c.mag = add_mag(a.mag,b.mag), c.neg = a.neg;
+  else if (compare_mag(a.mag,b.mag) >= 0) {
+    c.mag = sub_mag(a.mag,b.mag), c.neg = a.neg;
+  }
+  else c.mag = sub_mag(b.mag,a.mag), c.neg = b.neg;
+  if (c.zero()) c.neg = false;
+  return c;
+}
+
+bignum operator-(const bignum& a, const bignum& b) {
+  bignum c = b;
+  c.neg = !c.neg && !c.zero();
+  return a+c;
+}
+
+bignum operator*(const bignum& a, const bignum& b) {
+  bignum c;
+  c.mag = mul_mag(a.mag,b.mag);
+  c.neg = (a.neg != b.neg && !c.zero());
+  return c;
+}
+
+bignum operator/(const bignum& a, const bignum& b) {
+  bignum c;
+  c.mag = div_mag(a.mag,b.mag);
+  c.neg = (a.neg != b.neg && !c.zero());
+  return c;
+}
@@ -0,0 +1,27 @@
+#ifndef BIGNUM_HPP
+#define BIGNUM_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// arbitrary precision integers: sign and magnitude in 32-bit limbs, least
+// significant first and without leading zeros (zero has no limbs)
+struct bignum {
+  bool neg;
+  std::vector<uint32_t> mag;
+  bignum(int64_t v = 0);
+  static bignum parse(const std::string&); // optional '-', then digits
+  bool to_int64(int64_t&) const;           // false if it does not fit
+  double to_double() const;
+  std::string str() const;
+  bool zero() const { return mag.empty(); }
+};
+
+int compare(const bignum&, const bignum&);
+bignum operator+(const bignum&, const bignum&);
+bignum operator-(const bignum&, const bignum&);
+bignum operator*(const bignum&, const bignum&);
+bignum operator/(const bignum&, const bignum&); // truncated, divisor != 0
+
+#endif
@@ -1,4 +1,6 @@
+#include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "code.h"
 
@@ -6,45 +8,379 @@
 #include "syntax.h"
 #include "symbol.h"
 
-#define get_node(X)   (&vat(node,parser_st,(X)))
+// these use the ctx of the enclosing function
+#define get_node(X)   (&vat(node,ctx->st,(X)))
 #define child_id(X,Y) (vat(int,(X)->v,(Y)))
-#define child(X,Y)    (&vat(node,parser_st,child_id(X,Y)))
+#define child(X,Y)    (&vat(node,ctx->st,child_id(X,Y)))
 
 #define mark(X)   X |= (1<<31)
 #define seen(X)   ((X)&(1<<31))
-#define reg(X)    ((X)&~(1<<31))
+#define GLOBAL    (1<<30) // first occurrence made a heap variable
+#define UNSAFE    (1<<29) // first occurrence made an environment variable
+#define reg(X)    ((X)&~(7<<29))
 
-// symbol tables
-static int nxtprm,nxtreg;
-static symbol_table_t prmvar,tmpvar;
+#define CUT_LEVEL "!" // permanent variable holding the cut barrier
+#define is_call(X) ((X)->type == N_PREDICATE) // other goals are inline
+#define is_arith(X) (NBEGIN_ARITH < (X)->type && (X)->type < NEND_ARITH)
+
+#define WAM_NAME(X) #X,
+const char* const wam_name[] = { WAM_INSTRUCTIONS(WAM_NAME) };
+#undef WAM_NAME
+
+static char* vformat(const char* fmt, va_list ap) {
+  va_list aq;
+  va_copy(aq,ap);
+  int n = vsnprintf(NULL,0,fmt,aq);
+  va_end(aq);
+  char* text = malloc(n+1);
+  vsnprintf(text,n+1,fmt,ap);
+  return text;
+}
+// a label or index line, straight to the sink
+static void line(
+  compiler_t* ctx, int op, const char* src, const char* fmt, ...
+) {
+  va_list ap;
+  va_start(ap,fmt);
+  char* text = vformat(fmt,ap);
+  va_end(ap);
+  code_line L = {op,text,src,{{0,0},{0,0},{0,0}},0,0};
+  ctx->sink(&L,ctx->sink_data);
+  free(text);
+}
+// the source of a clause is printed to the line buffer, for its label
+static void out(compiler_t* ctx, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap,fmt);
+  int n = vsnprintf(NULL,0,fmt,ap);
+  va_end(ap);
+  if (ctx->line_n+n+1 > ctx->line_c) {
+    ctx->line = realloc(ctx->line,ctx->line_c = 2*(ctx->line_n+n+1));
+  }
+  va_start(ap,fmt);
+  vsnprintf(ctx->line+ctx->line_n,n+1,fmt,ap);
+  va_end(ap);
+  ctx->line_n += n;
+}
+
+// instruction list. the code of a clause (or the query) is collected here
+// and passed to the sink by flush_code after the peephole pass
+typedef code_operand operand;
+typedef struct {
+  int op;       // wam_op
+  char* text;   // constant, functor or variable name, or NULL
+  operand r[3]; // registers and immediates, in order
+  int n, has_n; // trailing integer (allocate, call, unify_void, set_void)
+} instruction;
+static const operand NONE = {0,0};
+
+#define xreg(I) ((operand){'X',I})
+#define code_at(I) (&vat(instruction,ctx->clause_code,(I)))
+
+static instruction* emit(
+  compiler_t* ctx, int op, operand a, operand b, operand c
+) {
+  instruction I = {op,NULL,{a,b,c},0,0};
+  vpush(instruction,ctx->clause_code,I);
+  return code_at(ctx->clause_code.n-1);
+}
+static instruction* emit_text(
+  compiler_t* ctx, int op, operand a, const char* fmt, ...
+) {
+  va_list ap;
+  va_start(ap,fmt);
+  instruction* I = emit(ctx,op,a,NONE,NONE);
+  I->text = vformat(fmt,ap);
+  va_end(ap);
+  return I;
+}
+static void with_int(instruction* I, int n) {
+  I->n = n;
+  I->has_n = 1;
+}
+
+// peephole pass. clause code is straight-line, so a backward scan gives the
+// live X registers. roles of the operands: R is read, W is written
+static const char* roles(instruction* I) {
+  static const struct { int op; const char* roles; } table[] = {
+    {WAM_put_structure,"W"}, {WAM_set_variable,"W"},
+    {WAM_unify_variable,"W"}, {WAM_put_variable,"WW"}, {WAM_put_value,"RW"},
+    {WAM_put_unsafe_value,"RW"}, {WAM_get_variable,"WR"}, {WAM_get_level,"W"},
+    {WAM_put_constant,"W"}, {WAM_put_list,"W"}, {WAM_put_nil,"W"},
+    {WAM_evaluate,"RW"}, {WAM_add,"RRW"}, {WAM_subtract,"RRW"},
+    {WAM_multiply,"RRW"}, {WAM_divide,"RRW"}
+  };
+  for (int i = 0; i < sizeof(table)/sizeof(table[0]); i++) {
+    if (I->op == table[i].op) return table[i].roles;
+  }
+  return "RRR";
+}
+static int is_x(operand a) { return a.c == 'X'; }
+static int op_is(instruction* I, int op) { return I->op == op; }
+// call f/n and execute f/n read X1..Xn and clobber the rest
+static int transfer(instruction* I) {
+  return op_is(I,WAM_call) || op_is(I,WAM_execute);
+}
+static int arity(instruction* I) { return atoi(strrchr(I->text,'/')+1); }
+// Xd := Xs, by get_variable Xd, Xs or put_value Xs, Xd
+static int move(instruction* I, int* d, int* s) {
+  operand a = I->r[0], b = I->r[1];
+  if (!is_x(a) || !is_x(b)) return 0;
+  if (op_is(I,WAM_get_variable)) *d = a.n, *s = b.n;
+  else if (op_is(I,WAM_put_value)) *d = b.n, *s = a.n;
+  else return 0;
+  return 1;
+}
+// reads of Xd after Xd := Xs read Xs, until either is written
+static int propagate(compiler_t* ctx) {
+  int changed = 0;
+  for (int i = 0; i < ctx->clause_code.n; i++) {
+    int d, s, stop = 0;
+    if (!move(code_at(i),&d,&s) || d == s) continue;
+    for (int k = i+1; k < ctx->clause_code.n && !stop; k++) {
+      instruction* I = code_at(k);
+      const char* rl = roles(I);
+      if (transfer(I)) break;
+      for (int j = 0; j < 3; j++) if (is_x(I->r[j])) {
+        if (rl[j] == 'R' && I->r[j].n == d) I->r[j].n = s, changed = 1;
+        if (rl[j] == 'W' && (I->r[j].n == d || I->r[j].n == s)) stop = 1;
+      }
+    }
+  }
+  return changed;
+}
+// moves to dead registers and self moves go. unify_variable and
+// set_variable of dead registers become unify_void 1 and set_void 1
+static int eliminate(compiler_t* ctx) {
+  int m = 0, changed = 0, w = ctx->clause_code.n;
+  for (int i = 0; i < ctx->clause_code.n; i++) for (int j = 0; j < 3; j++) {
+    operand a = code_at(i)->r[j];
+    if (is_x(a) && a.n > m) m = a.n;
+  }
+  char* live = calloc(m+1,1);
+  for (int k = ctx->clause_code.n-1; k >= 0; k--) {
+    instruction* I = code_at(k);
+    const char* rl = roles(I);
+    int d, s;
+    if (transfer(I)) {
+      memset(live,0,m+1);
+      for (int i = 1; i <= arity(I) && i <= m; i++) live[i] = 1;
+    }
+    else if (move(I,&d,&s) && (d == s || !live[d])) {
+      free(I->text);
+      changed = 1;
+      continue;
+    }
+    else if (
+      (op_is(I,WAM_unify_variable) || op_is(I,WAM_set_variable)) &&
+      is_x(I->r[0]) && !live[I->r[0].n]
+    ) {
+      I->op = op_is(I,WAM_set_variable) ? WAM_set_void : WAM_unify_void;
+      I->r[0] = NONE;
+      with_int(I,1);
+      changed = 1;
+    }
+    for (int j = 0; j < 3; j++) {
+      if (is_x(I->r[j]) && rl[j] == 'W') live[I->r[j].n] = 0;
+    }
+    for (int j = 0; j < 3; j++) {
+      if (is_x(I->r[j]) && rl[j] == 'R') live[I->r[j].n] = 1;
+    }
+    *code_at(--w) = *I;
+  }
+  free(live);
+  memmove(code_at(0),code_at(w),(ctx->clause_code.n-w)*sizeof(instruction));
+  ctx->clause_code.n -= w;
+  return changed;
+}
+static void peephole(compiler_t* ctx) {
+  while (propagate(ctx) | eliminate(ctx));
+  // runs of voids merge
+  int w = 0, calls = 0;
+  for (int i = 0; i < ctx->clause_code.n; i++) {
+    instruction* I = code_at(i);
+    calls += op_is(I,WAM_call);
+    if (
+      w && (op_is(I,WAM_unify_void) || op_is(I,WAM_set_void)) &&
+      op_is(code_at(w-1),I->op)
+    ) code_at(w-1)->n += I->n;
+    else *code_at(w++) = *I;
+  }
+  ctx->clause_code.n = w;
+  // rules without calls or permanent variables need no environment. the
+  // query has no deallocate and keeps its own
+  int rule = 0;
+  for (int i = 0; i < w; i++) rule |= op_is(code_at(i),WAM_deallocate);
+  if (calls || !rule || !op_is(code_at(0),WAM_allocate)) return;
+  if (code_at(0)->n) return;
+  w = 0;
+  for (int i = 1; i < ctx->clause_code.n; i++) {
+    if (!op_is(code_at(i),WAM_deallocate)) *code_at(w++) = *code_at(i);
+  }
+  ctx->clause_code.n = w;
+}
+static void flush_code(compiler_t* ctx) {
+  peephole(ctx);
+  for (int i = 0; i < ctx->clause_code.n; i++) {
+    instruction* I = code_at(i);
+    code_line L = {I->op,I->text,NULL,{I->r[0],I->r[1],I->r[2]},I->n,I->has_n};
+    ctx->sink(&L,ctx->sink_data);
+    free(I->text);
+  }
+  vclear(ctx->clause_code);
+}
+
+// constants (atoms and numbers) are the 0-arity structures. arithmetic
+// terms outside of arithmetic goals are the structures +/2, -/2, */2, //2.
+// lists are pairs of head and tail, like arithmetic terms
+static int is_constant(compiler_t* ctx, node* u) {
+  return u->type == N_STRUCTURE && !child(u,1)->v.n;
+}
+static int is_structure(compiler_t* ctx, node* u) {
+  if (u->type == N_STRUCTURE) return !is_constant(ctx,u);
+  return is_arith(u) || u->type == N_LIST;
+}
+static const char* functor_name(compiler_t* ctx, node* u) {
+  switch (u->type) {
+    case N_ADD: return "+";
+    case N_SUB: return "-";
+    case N_MUL: return "*";
+    case N_DIV: return "/";
+  }
+  return child(u,0)->tok.data;
+}
+static node* arguments(compiler_t* ctx, node* u) {
+  return (is_arith(u) || u->type == N_LIST) ? u : child(u,1);
+}
+static const char* constant(compiler_t* ctx, node* u) {
+  return child(u,0)->tok.data;
+}
+// op_constant c or op_nil, then register Xi if i > 0
+static void constant_code(compiler_t* ctx, int op, int nil, node* u, int i) {
+  operand a = i ? xreg(i) : NONE;
+  if (!strcmp(constant(ctx,u),"[]")) emit(ctx,nil,a,NONE,NONE);
+  else emit_text(ctx,op,a,"%s",constant(ctx,u));
+}
+// op_list Xi, or op_structure f/n, Xi
+static void structure_code(compiler_t* ctx, int op, int list, node* u) {
+  if (u->type == N_LIST) emit(ctx,list,xreg(u->val),NONE,NONE);
+  else {
+    int n = arguments(ctx,u)->v.n;
+    emit_text(ctx,op,xreg(u->val),"%s/%d",functor_name(ctx,u),n);
+  }
+}
 
 // permanent variables
-static void permanent_variables_dfs(node* u) {
-  if (u->type == N_VARIABLE) symget(prmvar,u->tok.data);
+static void permanent_variables_dfs(compiler_t* ctx, node* u) {
+  if (u->type == N_VARIABLE) symget(ctx->prmvar,u->tok.data);
   else for (int i = 0; i < u->v.n; i++) {
-    permanent_variables_dfs(child(u,i));
+    permanent_variables_dfs(ctx,child(u,i));
+  }
+}
+// chunk c+1 of each variable, or -1 if it occurs in more than one
+static void chunk_dfs(compiler_t* ctx, symbol_table_t* chk, node* u, int c) {
+  if (u->type == N_VARIABLE) {
+    symbol_t* s = symget(*chk,u->tok.data);
+    if (!s->val) s->val = c+1;
+    else if (s->val != c+1) s->val = -1;
+  }
+  else for (int i = 0; i < u->v.n; i++) chunk_dfs(ctx,chk,child(u,i),c);
+}
+// a chunk is a run of inline goals ended by a call. cuts past the first
+// chunk need the cut barrier of the clause saved in the environment
+static void cut_level(compiler_t* ctx, node* bd) {
+  for (int g = 0, c = 0; g < bd->v.n; c += is_call(child(bd,g)), g++) {
+    if (c && child(bd,g)->type == N_CUT) symget(ctx->prmvar,CUT_LEVEL);
+  }
+}
+// a rule variable is permanent if it occurs in more than one chunk. the
+// head goes with the first chunk
+static void rule_permanent_variables(compiler_t* ctx, node* hd, node* bd) {
+  symbol_table(chk);
+  chunk_dfs(ctx,&chk,hd,0);
+  for (int g = 0, c = 0; g < bd->v.n; c += is_call(child(bd,g)), g++) {
+    chunk_dfs(ctx,&chk,child(bd,g),c);
+  }
+  for (int i = 0; i < chk.table.n; i++) {
+    symbol_t* s = symat(chk,i);
+    if (s->val < 0) symget(ctx->prmvar,s->sym);
+  }
+  symdel(chk);
+  cut_level(ctx,bd);
+}
+// arity of the call ending the chunk of goal g
+static int chunk_arity(compiler_t* ctx, node* bd, int g) {
+  for (; g < bd->v.n; g++) if (is_call(child(bd,g))) {
+    return child(child(bd,g),1)->v.n;
   }
+  return 0;
+}
+static void last_goal_dfs(compiler_t* ctx, node* u, int g) {
+  symbol_t* s = NULL;
+  if (u->type == N_VARIABLE) s = symfind(ctx->prmvar,u->tok.data);
+  else if (u->type == N_CUT) s = symfind(ctx->prmvar,CUT_LEVEL);
+  if (s) vat(int,ctx->prmlst,s->i) = g;
+  for (int i = 0; i < u->v.n; i++) last_goal_dfs(ctx,child(u,i),g);
+}
+// Y1 is the variable used last, so a call keeps alive only the first N
+// variables of the environment and the rest can be trimmed.
+// with bd == NULL (queries) every variable lives until the end
+static void order_permanent(compiler_t* ctx, node* bd) {
+  vinit(ctx->prmreg);
+  vinit(ctx->prmlst);
+  for (int i = 0; i < ctx->prmvar.table.n; i++) {
+    vpush(int,ctx->prmreg,0);
+    vpush(int,ctx->prmlst,bd ? 0 : 1<<30);
+  }
+  if (bd) for (int g = 0; g < bd->v.n; g++) last_goal_dfs(ctx,child(bd,g),g);
+  for (int i = 0; i < ctx->prmvar.table.n; i++) {
+    int* r = &vat(int,ctx->prmreg,i);
+    int li = vat(int,ctx->prmlst,i);
+    *r = 1;
+    for (int j = 0; j < ctx->prmvar.table.n; j++) {
+      int lj = vat(int,ctx->prmlst,j);
+      if (lj > li || (lj == li && j < i)) (*r)++;
+    }
+  }
+}
+static int permanent_register(compiler_t* ctx, const char* sym) {
+  return vat(int,ctx->prmreg,symfind(ctx->prmvar,sym)->i);
+}
+static int last_goal(compiler_t* ctx, const char* sym) {
+  return vat(int,ctx->prmlst,symfind(ctx->prmvar,sym)->i);
 }
-static void save_permanent() {
-  for (int i = 0; i < prmvar.table.n; i++) {
-    symbol_t* ps = symat(prmvar,i);
-    symbol_t* ts = symfind(tmpvar,ps->sym);
+// number of permanent variables still needed after goal g
+static int live_after(compiler_t* ctx, int g) {
+  int n = 0;
+  for (int i = 0; i < ctx->prmvar.table.n; i++) {
+    n += (vat(int,ctx->prmlst,i) > g);
+  }
+  return n;
+}
+static void delete_permanent(compiler_t* ctx) {
+  vdelete(ctx->prmreg);
+  vdelete(ctx->prmlst);
+  symdel(ctx->prmvar);
+}
+static void save_permanent(compiler_t* ctx) {
+  for (int i = 0; i < ctx->prmvar.table.n; i++) {
+    symbol_t* ps = symat(ctx->prmvar,i);
+    symbol_t* ts = symfind(ctx->tmpvar,ps->sym);
     if (ts && ts->val) {
       mark(ts->val);
       ps->val = ts->val;
     }
   }
 }
-static void load_permanent() {
-  for (int i = 0; i < prmvar.table.n; i++) {
-    symbol_t* ps = symat(prmvar,i);
-    if (ps->val) symget(tmpvar,ps->sym)->val = ps->val;
+static void load_permanent(compiler_t* ctx) {
+  for (int i = 0; i < ctx->prmvar.table.n; i++) {
+    symbol_t* ps = symat(ctx->prmvar,i);
+    if (ps->val) symget(ctx->tmpvar,ps->sym)->val = ps->val;
   }
 }
 
 // query code
-static void goal_allocate(node* u, int ispred) {
-  if (ispred) nxtreg = u->v.n+1;
+static void goal_allocate(compiler_t* ctx, node* u, int ispred) {
   for (int i = 0; i < u->v.n; i++) {
     node* v = child(u,i);
     // non-variable roots
@@ -52,223 +388,475 @@ static void goal_allocate(node* u, int ispred) {
       v->val = i+1;
       continue;
     }
+    if (is_constant(ctx,v)) continue; // set_constant
     // non-variable non-roots or don't cares
     if (v->type != N_VARIABLE) { // !ispred || v->type == N_DONTCARE
-      v->val = nxtreg++;
+      v->val = ctx->nxtreg++;
       continue;
     }
     // variables
-    symbol_t* s = symget(tmpvar,v->tok.data);
-    if (!s->val) s->val = symfind(prmvar,v->tok.data) ? nxtprm++ : nxtreg++;
+    symbol_t* s = symget(ctx->tmpvar,v->tok.data);
+    if (s->val) continue;
+    if (symfind(ctx->prmvar,v->tok.data)) {
+      s->val = permanent_register(ctx,s->sym);
+    }
+    else s->val = ctx->nxtreg++;
   }
 }
-static void goal_dfs(node* u) {
+static void goal_dfs(compiler_t* ctx, node* u) {
   // code from children goes before
-  for (int i = 0; i < u->v.n; i++) goal_dfs(child(u,i));
+  for (int i = 0; i < u->v.n; i++) goal_dfs(ctx,child(u,i));
   // generate code
-  if (u->type == N_STRUCTURE) {
-    char* func = child(u,0)->tok.data;
-    node* trms = child(u,1);
-    printf("  put_structure %s/%d, X%d\n",func,trms->v.n,u->val);
+  if (is_structure(ctx,u)) {
+    node* trms = arguments(ctx,u);
+    structure_code(ctx,WAM_put_structure,WAM_put_list,u);
     for (int i = 0; i < trms->v.n; i++) {
       node* v = child(trms,i);
-      if (v->type == N_DONTCARE) printf("  set_variable X%d\n",v->val);
+      if (v->type == N_DONTCARE) {
+        emit(ctx,WAM_set_variable,xreg(v->val),NONE,NONE);
+      }
       else if (v->type == N_VARIABLE) {
         char c = 'X';
-        if (symfind(prmvar,v->tok.data)) c = 'Y';
-        int* val = &symget(tmpvar,v->tok.data)->val;
-        if (seen(*val)) printf("  set_value %c%d\n",c,reg(*val));
-        else printf("  set_variable %c%d\n",c,reg(*val));
+        if (symfind(ctx->prmvar,v->tok.data)) c = 'Y';
+        int* val = &symget(ctx->tmpvar,v->tok.data)->val;
+        int op = WAM_set_local_value;
+        if (!seen(*val)) op = WAM_set_variable;
+        else if (*val & GLOBAL) op = WAM_set_value;
+        emit(ctx,op,(operand){c,reg(*val)},NONE,NONE);
+        if (!seen(*val)) *val |= GLOBAL;
         mark(*val);
       }
-      else printf("  set_value X%d\n",v->val);
+      else if (is_constant(ctx,v)) {
+        constant_code(ctx,WAM_set_constant,WAM_set_nil,v,0);
+      }
+      else emit(ctx,WAM_set_value,xreg(v->val),NONE,NONE);
     }
   }
 }
-static void goal_roots(node* u) {
+// goal g of a rule body (rule = 1) or of the query (rule = 0)
+static void goal_roots(compiler_t* ctx, node* u, int g, int rule, int last) {
   char* func = child(u,0)->tok.data;
   node* trms = child(u,1);
   // for each root
   for (int i = 0; i < trms->v.n; i++) {
     node* v = child(trms,i);
-    if (v->type == N_DONTCARE) printf("  put_variable X%d, X%d\n",v->val,i+1);
+    if (v->type == N_DONTCARE) {
+      emit(ctx,WAM_put_variable,xreg(v->val),xreg(i+1),NONE);
+    }
     else if (v->type == N_VARIABLE) {
       char c = 'X';
-      if (symfind(prmvar,v->tok.data)) c = 'Y';
-      int* val = &symget(tmpvar,v->tok.data)->val;
-      if (seen(*val)) printf("  put_value %c%d, X%d\n",c,reg(*val),i+1);
-      else printf("  put_variable %c%d, X%d\n",c,reg(*val),i+1);
+      if (symfind(ctx->prmvar,v->tok.data)) c = 'Y';
+      int* val = &symget(ctx->tmpvar,v->tok.data)->val;
+      if (!seen(*val)) {
+        emit(ctx,WAM_put_variable,(operand){c,reg(*val)},xreg(i+1),NONE);
+        *val |= (c == 'Y' ? UNSAFE : GLOBAL);
+      }
+      else if (rule && (*val & UNSAFE) && last_goal(ctx,v->tok.data) == g) {
+        // the environment may be gone (or trimmed) when the callee reads it
+        emit(ctx,WAM_put_unsafe_value,(operand){'Y',reg(*val)},xreg(i+1),NONE);
+      }
+      else emit(ctx,WAM_put_value,(operand){c,reg(*val)},xreg(i+1),NONE);
       mark(*val);
     }
-    else goal_dfs(v);
+    else if (is_constant(ctx,v)) {
+      constant_code(ctx,WAM_put_constant,WAM_put_nil,v,i+1);
+    }
+    else goal_dfs(ctx,v);
+  }
+  int n = trms->v.n;
+  if (rule && last) {
+    emit(ctx,WAM_deallocate,NONE,NONE,NONE);
+    emit_text(ctx,WAM_execute,NONE,"%s/%d",func,n);
+  }
+  else with_int(emit_text(ctx,WAM_call,NONE,"%s/%d",func,n),live_after(ctx,g));
+}
+// BFS for register allocation
+static void goal_bfs(compiler_t* ctx, int g) {
+  vector(Q); // queue
+  vpush(int,Q,g);
+  for (int front = 0; front < Q.n; front++) {
+    node* v = get_node(vat(int,Q,front));
+    if (v->type == N_PREDICATE || is_structure(ctx,v)) {
+      goal_allocate(ctx,arguments(ctx,v),v->type == N_PREDICATE);
+    }
+    for (int i = 0; i < v->v.n; i++) vpush(int,Q,child_id(v,i));
+  }
+  vdelete(Q);
+}
+// cuts before the first call (c = 0) use the barrier still in B0
+static void cut_code(compiler_t* ctx, int c) {
+  if (!c) emit(ctx,WAM_neck_cut,NONE,NONE,NONE);
+  else {
+    operand y = {'Y',permanent_register(ctx,CUT_LEVEL)};
+    emit(ctx,WAM_cut,y,NONE,NONE);
+  }
+}
+
+// arithmetic goals. operands are registers or immediates (#n), values are
+// integer cells and results go to fresh temporaries
+// constant integer subexpressions whose value fits an immediate. floats
+// and larger integers are left to the machine
+static int fold(compiler_t* ctx, node* u, int* v) {
+  if (is_constant(ctx,u)) {
+    char* end;
+    long long r = strtoll(constant(ctx,u),&end,10);
+    *v = r;
+    return !*end && r == *v;
+  }
+  int a, b;
+  if (!is_arith(u)) return 0;
+  if (!fold(ctx,child(u,0),&a) || !fold(ctx,child(u,1),&b)) return 0;
+  long long r;
+  switch (u->type) {
+    case N_ADD: r = (long long)a+b; break;
+    case N_SUB: r = (long long)a-b; break;
+    case N_MUL: r = (long long)a*b; break;
+    default:
+      if (!b) return 0; // zero divisor, at run time
+      r = (long long)a/b;
+  }
+  if (r != (int)r) return 0;
+  *v = r;
+  return 1;
+}
+// unbound on first occurrence: evaluation fails with an instantiation error
+static operand variable_operand(compiler_t* ctx, node* u) {
+  char c = 'X';
+  if (symfind(ctx->prmvar,u->tok.data)) c = 'Y';
+  int* val = &symget(ctx->tmpvar,u->tok.data)->val;
+  if (!seen(*val)) {
+    *val = (c == 'Y' ? permanent_register(ctx,u->tok.data) : ctx->nxtreg++);
+    operand a = {c,*val};
+    emit(ctx,WAM_put_variable,a,xreg(c == 'Y' ? ctx->nxtreg++ : *val),NONE);
+    *val |= (c == 'Y' ? UNSAFE : GLOBAL);
+    mark(*val);
+  }
+  return (operand){c,reg(*val)};
+}
+// other terms are built and evaluated at run time
+static operand term_operand(compiler_t* ctx, int id) {
+  node* u = get_node(id);
+  if (u->type == N_VARIABLE) return variable_operand(ctx,u);
+  u->val = ctx->nxtreg++;
+  if (u->type == N_DONTCARE) {
+    emit(ctx,WAM_put_variable,xreg(u->val),xreg(u->val),NONE);
+  }
+  else if (is_constant(ctx,u)) {
+    constant_code(ctx,WAM_put_constant,WAM_put_nil,u,u->val);
+  }
+  else {
+    goal_bfs(ctx,id);
+    goal_dfs(ctx,u);
+  }
+  return (operand){'X',u->val};
+}
+static operand arith_code(compiler_t* ctx, int id) {
+  node* u = get_node(id);
+  int v;
+  if (fold(ctx,u,&v)) return (operand){'#',v};
+  if (!is_arith(u)) return term_operand(ctx,id);
+  operand a = arith_code(ctx,child_id(u,0)), b = arith_code(ctx,child_id(u,1));
+  int op = WAM_divide;
+  if (u->type == N_ADD) op = WAM_add;
+  else if (u->type == N_SUB) op = WAM_subtract;
+  else if (u->type == N_MUL) op = WAM_multiply;
+  int d = ctx->nxtreg++;
+  emit(ctx,op,a,b,xreg(d));
+  return (operand){'X',d};
+}
+// the first occurrence of X in X is E takes the register of the value
+static void is_code(compiler_t* ctx, node* u) {
+  node* lhs = child(u,0);
+  node* rhs = child(u,1);
+  operand v = arith_code(ctx,child_id(u,1));
+  if (v.c != '#' && !is_arith(rhs)) { // plain terms are evaluated too
+    int d = ctx->nxtreg++;
+    emit(ctx,WAM_evaluate,v,xreg(d),NONE);
+    v = (operand){'X',d};
+  }
+  int* val = NULL;
+  if (lhs->type == N_VARIABLE) val = &symget(ctx->tmpvar,lhs->tok.data)->val;
+  if (val && !seen(*val)) {
+    char c = 'X';
+    if (symfind(ctx->prmvar,lhs->tok.data)) c = 'Y';
+    if (c == 'X' && v.c == 'X') *val = v.n;
+    else {
+      *val = (c == 'Y' ? permanent_register(ctx,lhs->tok.data) : ctx->nxtreg++);
+      operand a = {c,*val};
+      if (v.c == '#') emit_text(ctx,WAM_put_constant,a,"%d",v.n);
+      else emit(ctx,WAM_get_variable,a,v,NONE);
+    }
+    *val |= GLOBAL;
+    mark(*val);
+  }
+  else if (lhs->type != N_DONTCARE) {
+    operand l = term_operand(ctx,child_id(u,0));
+    if (v.c == '#') emit_text(ctx,WAM_get_constant,l,"%d",v.n);
+    else emit(ctx,WAM_get_value,l,v,NONE);
   }
-  printf("  call %s/%d\n",func,trms->v.n);
 }
-static void goals(node* u) {
+static void compare_code(compiler_t* ctx, node* u) {
+  static const struct { const char* name; int op; } op[] = {
+    {"=:=",WAM_compare_eq}, {"=\\=",WAM_compare_ne}, {"<",WAM_compare_lt},
+    {">",WAM_compare_gt}, {"=<",WAM_compare_le}, {">=",WAM_compare_ge}
+  };
+  int i = 0;
+  while (strcmp(op[i].name,u->tok.data)) i++;
+  operand a = arith_code(ctx,child_id(u,0)), b = arith_code(ctx,child_id(u,1));
+  emit(ctx,op[i].op,a,b,NONE);
+}
+
+// rule bodies deallocate before their last goal (LCO). temporaries and
+// registers live through a chunk, and a rule's head goes with the first one
+static void goals(compiler_t* ctx, node* u, int rule) {
   // for each goal
-  for (int i = 0; i < u->v.n; i++) {
-    syminit(tmpvar);
-    load_permanent();
+  for (int i = 0, c = 0; i < u->v.n; i++) {
     int g = child_id(u,i);
-    // BFS for register allocation
-    vector(Q); // queue
-    vpush(int,Q,g);
-    for (int front = 0; front < Q.n; front++) {
-      node* v = get_node(vat(int,Q,front));
-      if (v->type == N_PREDICATE || v->type == N_STRUCTURE) {
-        goal_allocate(child(v,1),v->type == N_PREDICATE);
-      }
-      for (int i = 0; i < v->v.n; i++) vpush(int,Q,child_id(v,i));
+    node* v = get_node(g);
+    int last = (i == u->v.n-1);
+    if (i == 0 ? !rule : is_call(child(u,i-1))) { // new chunk
+      syminit(ctx->tmpvar);
+      load_permanent(ctx);
+      ctx->nxtreg = chunk_arity(ctx,u,i)+1;
+    }
+    if (v->type == N_CUT) cut_code(ctx,c);
+    else if (v->type == N_IS) is_code(ctx,v);
+    else if (v->type == N_COMPARE) compare_code(ctx,v);
+    else {
+      goal_bfs(ctx,g);
+      goal_roots(ctx,v,i,rule,last);
+      c++;
+    }
+    if (rule && last && !is_call(v)) {
+      emit(ctx,WAM_deallocate,NONE,NONE,NONE);
+      emit(ctx,WAM_proceed,NONE,NONE,NONE);
     }
-    vdelete(Q);
-    goal_roots(get_node(g));
-    save_permanent();
-    symdel(tmpvar);
+    save_permanent(ctx);
+    if (last || is_call(v)) symdel(ctx->tmpvar);
   }
 }
-static void query() {
+static void get_level(compiler_t* ctx) {
+  if (!symfind(ctx->prmvar,CUT_LEVEL)) return;
+  operand y = {'Y',permanent_register(ctx,CUT_LEVEL)};
+  emit(ctx,WAM_get_level,y,NONE,NONE);
+}
+static void query(compiler_t* ctx) {
   node* u = child(get_node(0),1);
   if (u->v.n) {
-    syminit(prmvar);
-    permanent_variables_dfs(u);
-    nxtprm = 1;
-    printf("query:\n");
-    printf("  allocate %d\n",prmvar.table.n);
-    goals(u);
-    for (int i = 0; i < prmvar.table.n; i++) {
-      symbol_t* s = symat(prmvar,i);
-      printf("  print_variable Y%d, %s\n",reg(s->val),s->sym);
+    syminit(ctx->prmvar);
+    permanent_variables_dfs(ctx,u);
+    cut_level(ctx,u);
+    order_permanent(ctx,NULL);
+    line(ctx,CODE_LABEL,NULL,"query");
+    with_int(emit(ctx,WAM_allocate,NONE,NONE,NONE),ctx->prmvar.table.n);
+    get_level(ctx);
+    goals(ctx,u,0);
+    for (int i = 0; i < ctx->prmvar.table.n; i++) {
+      symbol_t* s = symat(ctx->prmvar,i);
+      if (s == symfind(ctx->prmvar,CUT_LEVEL)) continue;
+      emit_text(ctx,WAM_print_variable,(operand){'Y',reg(s->val)},"%s",s->sym);
     }
-    printf("  flush_variables\n");
-    printf("  wait_user\n");
-    symdel(prmvar);
+    emit(ctx,WAM_flush_variables,NONE,NONE,NONE);
+    emit(ctx,WAM_wait_user,NONE,NONE,NONE);
+    flush_code(ctx);
+    delete_permanent(ctx);
   }
 }
 
 // program code
-static void head_code(node* u) {
+static void head_code(compiler_t* ctx, node* u) {
   if (u->type == N_DONTCARE) { // one of the roots
-    printf("  get_variable X%d, X%d\n",nxtreg++,u->val);
+    emit(ctx,WAM_get_variable,xreg(ctx->nxtreg++),xreg(u->val),NONE);
   }
   else if (u->type == N_VARIABLE) { // one of the roots
     char c = 'X';
-    int* nxt = &nxtreg;
-    if (symfind(prmvar,u->tok.data)) c = 'Y', nxt = &nxtprm;
-    symbol_t* s = symget(tmpvar,u->tok.data);
-    if (s->val) printf("  get_value %c%d, X%d\n",c,s->val,u->val);
+    if (symfind(ctx->prmvar,u->tok.data)) c = 'Y';
+    symbol_t* s = symget(ctx->tmpvar,u->tok.data);
+    operand r = {c,reg(s->val)};
+    if (s->val) emit(ctx,WAM_get_value,r,xreg(u->val),NONE);
     else {
-      s->val = (*nxt)++;
-      printf("  get_variable %c%d, X%d\n",c,s->val,u->val);
+      s->val = (c == 'Y' ? permanent_register(ctx,s->sym) : ctx->nxtreg++);
+      emit(ctx,WAM_get_variable,(operand){c,s->val},xreg(u->val),NONE);
     }
   }
-  else { // N_STRUCTURE
-    char* func = child(u,0)->tok.data;
-    node* trms = child(u,1);
-    printf("  get_structure %s/%d, X%d\n",func,trms->v.n,u->val);
+  else if (is_constant(ctx,u)) { // one of the roots
+    constant_code(ctx,WAM_get_constant,WAM_get_nil,u,u->val);
+  }
+  else { // N_STRUCTURE, arithmetic or N_LIST
+    node* trms = arguments(ctx,u);
+    structure_code(ctx,WAM_get_structure,WAM_get_list,u);
     for (int i = 0; i < trms->v.n; i++) {
       node* v = child(trms,i);
-      if (v->type != N_VARIABLE) {
-        v->val = nxtreg++;
-        printf("  unify_variable X%d\n",v->val);
+      if (is_constant(ctx,v)) {
+        constant_code(ctx,WAM_unify_constant,WAM_unify_nil,v,0);
+      }
+      else if (v->type != N_VARIABLE) {
+        v->val = ctx->nxtreg++;
+        emit(ctx,WAM_unify_variable,xreg(v->val),NONE,NONE);
       }
       else {
         char c = 'X';
-        int* nxt = &nxtreg;
-        if (symfind(prmvar,v->tok.data)) c = 'Y', nxt = &nxtprm;
-        symbol_t* s = symget(tmpvar,v->tok.data);
-        if (s->val) printf("  unify_value %c%d\n",c,s->val);
-        else {
-          s->val = (*nxt)++;
-          printf("  unify_variable %c%d\n",c,s->val);
+        if (symfind(ctx->prmvar,v->tok.data)) c = 'Y';
+        symbol_t* s = symget(ctx->tmpvar,v->tok.data);
+        if (!s->val) {
+          s->val = (c == 'Y' ? permanent_register(ctx,s->sym) : ctx->nxtreg++);
+          emit(ctx,WAM_unify_variable,(operand){c,s->val},NONE,NONE);
+          s->val |= GLOBAL;
         }
+        else emit(ctx,
+          s->val & GLOBAL ? WAM_unify_value : WAM_unify_local_value,
+          (operand){c,reg(s->val)},NONE,NONE
+        );
       }
     }
   }
 }
-static void head(node* u) {
-  nxtreg = u->v.n+1;
-  syminit(tmpvar);
+// temporaries start at X(nreg+1), past the argument registers in the chunk
+static void head(compiler_t* ctx, node* u, int nreg) {
+  ctx->nxtreg = nreg+1;
   // BFS
   vector(Q); // queue
   // handle roots separately and push roots' children
   for (int i = 0; i < u->v.n; i++) {
     node* v = child(u,i);
     v->val = i+1;
-    head_code(v);
+    head_code(ctx,v);
     for (int j = 0; j < v->v.n; j++) vpush(int,Q,child_id(v,j));
   }
   // BFS loop
   for (int front = 0; front < Q.n; front++) {
     node* v = get_node(vat(int,Q,front));
-    if (v->type == N_STRUCTURE) head_code(v);
+    if (is_structure(ctx,v)) head_code(ctx,v);
     for (int i = 0; i < v->v.n; i++) vpush(int,Q,child_id(v,i));
   }
   vdelete(Q);
-  save_permanent();
-  symdel(tmpvar);
+  for (int i = 0; i < ctx->tmpvar.table.n; i++) mark(symat(ctx->tmpvar,i)->val);
+  save_permanent(ctx);
+}
+// operators are left associative. 0: goals, 1: + and -, 2: * and /
+static int precedence(node* u) {
+  if (u->type == N_IS || u->type == N_COMPARE) return 0;
+  if (u->type == N_ADD || u->type == N_SUB) return 1;
+  if (u->type == N_MUL || u->type == N_DIV) return 2;
+  return 3;
+}
+static void print_dfs(compiler_t* ctx, node* u);
+static void print_operand(compiler_t* ctx, node* u, int parens) {
+  if (parens) out(ctx,"(");
+  print_dfs(ctx,u);
+  if (parens) out(ctx,")");
 }
-static void print_dfs(node* u) {
-  if (u->type == N_DONTCARE) printf("_");
-  else if (u->type == N_ATOM || u->type == N_VARIABLE) printf("%s",u->tok.data);
+static void print_dfs(compiler_t* ctx, node* u) {
+  if (u->type == N_DONTCARE) out(ctx,"_");
+  else if (u->type == N_CUT) out(ctx,"!");
+  else if (
+    u->type == N_ATOM ||
+    u->type == N_NUMBER ||
+    u->type == N_VARIABLE
+  ) out(ctx,"%s",u->tok.data);
+  else if (u->type == N_LIST) {
+    out(ctx,"[");
+    print_dfs(ctx,child(u,0));
+    for (u = child(u,1); u->type == N_LIST; u = child(u,1)) {
+      out(ctx,",");
+      print_dfs(ctx,child(u,0));
+    }
+    if (!is_constant(ctx,u) || strcmp(constant(ctx,u),"[]")) {
+      out(ctx,"|");
+      print_dfs(ctx,u);
+    }
+    out(ctx,"]");
+  }
+  else if (precedence(u) < 3) {
+    int p = precedence(u);
+    print_operand(ctx,child(u,0),precedence(child(u,0)) < p);
+    if (u->type == N_IS) out(ctx," is ");
+    else if (u->type == N_COMPARE) out(ctx," %s ",u->tok.data);
+    else out(ctx,"%s",functor_name(ctx,u));
+    print_operand(ctx,child(u,1),precedence(child(u,1)) <= p);
+  }
   else if (
     u->type == N_PREDICATE ||
     u->type == N_FACT ||
     u->type == N_STRUCTURE
   ) {
-    print_dfs(child(u,0));
+    print_dfs(ctx,child(u,0));
     node* trms = child(u,1);
     if (!trms->v.n) return;
-    printf("(");
+    out(ctx,"(");
     for (int i = 0; i < trms->v.n; i++) {
-      if (i > 0) printf(",");
-      print_dfs(child(trms,i));
+      if (i > 0) out(ctx,",");
+      print_dfs(ctx,child(trms,i));
     }
-    printf(")");
+    out(ctx,")");
+  }
+}
+// first argument key, for clause indexing
+static void index_key(compiler_t* ctx, node* trms) {
+  if (!trms->v.n) return;
+  node* v = child(trms,0);
+  if (is_constant(ctx,v)) line(ctx,CODE_INDEX,NULL,"%s",constant(ctx,v));
+  else if (v->type == N_LIST) line(ctx,CODE_INDEX,NULL,"[|]");
+  else if (is_structure(ctx,v)) {
+    int n = arguments(ctx,v)->v.n;
+    line(ctx,CODE_INDEX,NULL,"%s/%d",functor_name(ctx,v),n);
   }
 }
-static void fact(node* u) {
+static void fact(compiler_t* ctx, node* u) {
   char* func = child(u,0)->tok.data;
   node* trms = child(u,1);
-  printf("%s/%d: ",func,trms->v.n);
-  print_dfs(u);
-  printf(".\n");
-  head(trms);
-  printf("  proceed\n");
+  ctx->line_n = 0;
+  print_dfs(ctx,u);
+  out(ctx,".");
+  line(ctx,CODE_LABEL,ctx->line,"%s/%d",func,trms->v.n);
+  order_permanent(ctx,NULL);
+  index_key(ctx,trms);
+  syminit(ctx->tmpvar);
+  head(ctx,trms,trms->v.n);
+  symdel(ctx->tmpvar);
+  emit(ctx,WAM_proceed,NONE,NONE,NONE);
+  flush_code(ctx);
 }
-static void rule(node* u) {
+static void rule(compiler_t* ctx, node* u) {
   node* hd = child(u,0);
   node* bd = child(u,1);
   char* func = child(hd,0)->tok.data;
   node* trms = child(hd,1);
-  permanent_variables_dfs(hd);
-  permanent_variables_dfs(bd);
-  nxtprm = 1;
-  printf("%s/%d: ",func,trms->v.n);
-  print_dfs(hd);
-  printf(" :- ");
+  rule_permanent_variables(ctx,hd,bd);
+  order_permanent(ctx,bd);
+  ctx->line_n = 0;
+  print_dfs(ctx,hd);
+  out(ctx," :- ");
   for (int i = 0; i < bd->v.n; i++) {
-    if (i > 0) printf(", ");
-    print_dfs(child(bd,i));
+    if (i > 0) out(ctx,", ");
+    print_dfs(ctx,child(bd,i));
   }
-  printf(".\n");
-  printf("  allocate %d\n",prmvar.table.n);
-  head(trms);
-  goals(bd);
-  printf("  deallocate\n");
+  out(ctx,".");
+  line(ctx,CODE_LABEL,ctx->line,"%s/%d",func,trms->v.n);
+  index_key(ctx,trms);
+  with_int(emit(ctx,WAM_allocate,NONE,NONE,NONE),ctx->prmvar.table.n);
+  get_level(ctx);
+  int nreg = trms->v.n, first = chunk_arity(ctx,bd,0);
+  syminit(ctx->tmpvar);
+  head(ctx,trms,nreg > first ? nreg : first);
+  goals(ctx,bd,1);
+  flush_code(ctx);
 }
-static void program() {
+static void program(compiler_t* ctx) {
   // for each clause
   node* cls = child(get_node(0),0);
   for (int i = 0; i < cls->v.n; i++) {
-    syminit(prmvar);
+    syminit(ctx->prmvar);
     node* u = child(cls,i);
-    if(u->type == N_FACT) fact(u);
-    else rule(u);
-    symdel(prmvar);
+    if(u->type == N_FACT) fact(ctx,u);
+    else rule(ctx,u);
+    delete_permanent(ctx);
   }
 }
 
-void code() {
-  program();
-  query();
+void code(compiler_t* ctx) {
+  program(ctx);
+  query(ctx);
+  vdelete(ctx->clause_code);
+  free(ctx->line);
 }
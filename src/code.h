@@ -1,6 +1,42 @@
 #ifndef CODE_H
 #define CODE_H
 
-void code();
+// WAM instructions, by the names of the assembly text
+#define WAM_INSTRUCTIONS(X) \
+  X(put_structure) X(set_variable) X(set_value) X(set_void) \
+  X(set_local_value) X(get_structure) X(unify_variable) X(unify_value) \
+  X(unify_local_value) X(unify_void) X(call) X(execute) X(proceed) \
+  X(put_variable) X(put_value) X(put_unsafe_value) X(get_variable) \
+  X(get_value) X(allocate) X(deallocate) X(neck_cut) X(get_level) X(cut) \
+  X(put_constant) X(get_constant) X(set_constant) X(unify_constant) \
+  X(put_list) X(get_list) X(put_nil) X(get_nil) X(set_nil) X(unify_nil) \
+  X(evaluate) X(add) X(subtract) X(multiply) X(divide) \
+  X(compare_eq) X(compare_ne) X(compare_lt) X(compare_gt) X(compare_le) \
+  X(compare_ge) X(print_variable) X(flush_variables) X(wait_user)
+#define WAM_OP(X) WAM_##X,
+typedef enum { WAM_INSTRUCTIONS(WAM_OP) WAM_COUNT } wam_op;
+#undef WAM_OP
+extern const char* const wam_name[];
+
+// one line of WAM code: a label, the first argument key of the next clause
+// or an instruction. the text form is what print_line writes
+#define CODE_LABEL -1
+#define CODE_INDEX -2
+typedef struct { char c; int n; } code_operand; // c is X, Y, # or 0 (none)
+typedef struct {
+  int op;              // a wam_op, CODE_LABEL or CODE_INDEX
+  const char* text;    // label, key, functor, constant or variable name
+  const char* src;     // source of the clause of a label, or NULL
+  code_operand r[3];   // registers and immediates, in order
+  int n, has_n;        // trailing integer (allocate, call, unify_void, ...)
+} code_line;
+
+// receives each line of WAM code
+typedef void (*code_sink)(const code_line* line, void* data);
+
+typedef struct compiler compiler_t;
+
+// code of the parsed program, to the sink of the compiler
+void code(compiler_t*);
 
 #endif
@@ -3,29 +3,73 @@
 #include "compiler.h"
 
 #include "parser.h"
-#include "code.h"
 
 // flex/bison stuff
-int yyparse();
-void yy_scan_string(const char*);
-extern FILE* yyin;
-
-static int do_compile() {
-  parser_init();
-  yyparse();
-  if (!parser_error_flag) code();
-  parser_close();
-  return parser_error_flag;
+typedef void* yyscan_t;
+int yyparse(yyscan_t, compiler_t*);
+int yylex_init_extra(compiler_t*, yyscan_t*);
+struct yy_buffer_state* yy_scan_string(const char*, yyscan_t);
+void yyset_in(FILE*, yyscan_t);
+int yylex_destroy(yyscan_t);
+
+// each compilation has its own context, scanner and parser, so compilations
+// can run on several threads at once
+static void compiler_init(
+  compiler_t* ctx, const char* fn, code_sink f, void* data
+) {
+  parser_init(ctx,fn);
+  ctx->sink = f;
+  ctx->sink_data = data;
+  yylex_init_extra(ctx,&ctx->scanner);
+}
+
+static int do_compile(compiler_t* ctx) {
+  yyparse(ctx->scanner,ctx);
+  yylex_destroy(ctx->scanner);
+  if (!ctx->error_flag) code(ctx);
+  parser_close(ctx);
+  return ctx->error_flag;
+}
+
+int compile(const char* src, code_sink f, void* data) {
+  compiler_t ctx;
+  compiler_init(&ctx,"stdin",f,data);
+  yy_scan_string(src,ctx.scanner);
+  return do_compile(&ctx);
 }
 
-int compile(const char* src) {
-  parser_fn = "stdin";
-  yy_scan_string(src);
-  return do_compile();
+int compile_file(const char* fn, code_sink f, void* data) {
+  FILE* fp = fopen(fn,"r");
+  if (!fp) {
+    fprintf(stderr,"%s: cannot open file\n",fn);
+    return 1;
+  }
+  compiler_t ctx;
+  compiler_init(&ctx,fn,f,data);
+  yyset_in(fp,ctx.scanner);
+  int st = do_compile(&ctx);
+  fclose(fp);
+  return st;
 }
 
-int compile_file(const char* fn) {
-  parser_fn = fn;
-  yyin = fopen(fn,"r");
-  return do_compile();
+void print_line(const code_line* L, void* data) {
+  FILE* fp = data;
+  if (L->op == CODE_LABEL) {
+    fprintf(fp,"%s:",L->text);
+    if (L->src) fprintf(fp," %s",L->src);
+  }
+  else if (L->op == CODE_INDEX) fprintf(fp,"  index %s",L->text);
+  else {
+    int last = (L->op == WAM_print_variable); // the name after the register
+    const char* sep = " ";
+    fprintf(fp,"  %s",wam_name[L->op]);
+    if (L->text && !last) fprintf(fp,"%s%s",sep,L->text), sep = ", ";
+    for (int j = 0; j < 3 && L->r[j].c; j++) {
+      fprintf(fp,"%s%c%d",sep,L->r[j].c,L->r[j].n);
+      sep = ", ";
+    }
+    if (last) fprintf(fp,", %s",L->text);
+    if (L->has_n) fprintf(fp,"%s%d",sep,L->n);
+  }
+  fputc('\n',fp);
 }
@@ -1,7 +1,15 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
-int compile(const char*);
-int compile_file(const char*);
+#include "code.h"
+
+// compile Prolog text, passing the WAM code to the sink a line at a time.
+// return 1 on errors, which go to stderr. compilations share no state, so
+// several may run at once on different threads
+int compile(const char*, code_sink, void* data);
+int compile_file(const char*, code_sink, void* data);
+
+// sink printing the lines to a FILE* as WAM assembly text
+void print_line(const code_line*, void* fp);
 
 #endif
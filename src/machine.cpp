@@ -1,9 +1,23 @@
 #include <iostream>
 #include <sstream>
-#include <functional>
+#include <unordered_map>
+#include <set>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <climits>
+
+#include <csetjmp>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "machine.hpp"
 
+#include "bignum.hpp"
+
 #include "helper.hpp"
 
 using namespace std;
@@ -19,7 +33,10 @@ using namespace std;
 
 enum fatal_error {
   INVALID_REGISTER = 1,
-  EMPTY_INSTRUCTION
+  EMPTY_INSTRUCTION,
+  LITERAL_OVERFLOW,
+  OUT_OF_MEMORY,
+  CODE_OVERFLOW
 };
 #define fatal(ERR,fmt,...) {\
   fprintf(stderr,"fatal error (%s): ",#ERR);\
@@ -28,73 +45,115 @@ enum fatal_error {
   exit(ERR);\
 }
 
-struct cvt {
-  stringstream ss;
-  template <typename T>
-  cvt(T x) {
-    ss << x;
-  }
-  template <typename T>
-  operator T() {
-    T ans;
-    ss >> ans;
-    return ans;
-  }
-  string str() {
-    string ans;
-    ss >> ans;
-    return ans;
-  }
-};
+// computed goto is a GNU extension. other compilers get the switch loop
+#if !defined(__GNUC__) && !defined(WAM_SWITCH)
+#define WAM_SWITCH
+#endif
 
 // =============================================================================
 // types and globals
 // =============================================================================
 
-#define MAXN  (1<<20)
+// memory areas are reserved as virtual memory, so pages take RAM only once
+// they are used. the store is registers, literals, heap and stack, in this
+// order. the heap and stack sizes are set by machine_memory()
 #define X0    (0)
+#define LIT0  (1<<17) // literal pool, below the heap
 #define H0    (1<<18)
-#define YA0   (3<<18)
-
-// code
-struct instruction {
-  virtual ~instruction() {}
-  virtual void run() const = 0;
+static int HN;       // the heap is [H0,HN)
+static int YA0, YAN; // the stack is [YA0,YAN)
+
+// a PROT_NONE guard follows each area, so overflows fault instead of
+// corrupting the next area, with no checks in the instructions. the fault
+// handler turns them into resource errors
+#define GUARD (1<<16) // bytes
+struct guard {
+  char* beg;
+  const char* area;
 };
-static instruction* CODE[MAXN] = {};
-static int CODE_SIZE = 0;
-static int P, CP; // instruction pointers
-static void free_code(int beg = 0) {
-  while (beg < CODE_SIZE) {
-    CODE_SIZE--;
-    delete CODE[CODE_SIZE];
-    CODE[CODE_SIZE] = nullptr;
-  }
+static guard GUARDS[8];
+static int GUARDS_SIZE;
+static void protect(void* beg, const char* area) {
+  mprotect(beg,GUARD,PROT_NONE);
+  GUARDS[GUARDS_SIZE++] = {(char*)beg,area};
 }
-static void free_query() {
-  free_code(symbol_table["query"][0].P);
-  symbol_table.erase("query");
+static int64_t page_round(int64_t bytes) {
+  int64_t page = sysconf(_SC_PAGESIZE);
+  return (bytes+page-1)/page*page;
+}
+template<typename T> static T* reserve(int64_t n, const char* area) {
+  int64_t bytes = page_round(n*sizeof(T));
+  void* p = mmap(
+    nullptr,bytes+GUARD,PROT_READ|PROT_WRITE,
+    MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE,-1,0
+  );
+  if (p == MAP_FAILED) fatal(OUT_OF_MEMORY,"%lld bytes",(long long)bytes);
+  protect((char*)p+bytes,area);
+  return (T*)p;
 }
 
 // data types
 enum tag {
   NAT, // Not A Tag
-  REF,
-  STR,
-  FCT
+  REF, // address of a cell
+  STR, // address of a FCT cell
+  FCT, // functor id
+  CON, // atom id
+  INT, // small integer
+  LIS, // address of a list pair
+  NUM  // address of a boxed number
 };
-typedef pair<tag,int>    data;
-typedef pair<string,int> functor;
-static string func2lab(const functor& f) {
-  return f.first+"/"+cvt(f.second).str();
+// cells: one word with the tag in the low bits and the value above them
+typedef uint64_t cell;
+#define TAG_BITS 3
+static inline cell data(tag t, int64_t v) { return uint64_t(v)<<TAG_BITS | t; }
+static inline tag tag_of(cell c) { return tag(c & ((1<<TAG_BITS)-1)); }
+static inline int64_t val_of(cell c) { return int64_t(c) >> TAG_BITS; }
+
+// boxed numbers: a NAT header with the kind and the size, then raw words.
+// integers are boxed only if they do not fit an INT cell
+enum box { BOX_INT64, BOX_FLOAT, BOX_BIG, BOX_NEG_BIG };
+static inline cell box_header(box k, int n) { return data(NAT,n<<2 | k); }
+static inline box box_kind(cell h) { return box(val_of(h) & 3); }
+static inline int box_size(cell h) { return val_of(h) >> 2; }
+
+// interned atoms and functors. ids are dense and given at assembly time, so
+// the machine compares symbols as integers. FCT cells hold functor ids
+struct functor {
+  int name, arity;
+  string label; // name/arity
+};
+static vector<string> ATOM;
+static unordered_map<string,int> ATOM_ID;
+static vector<functor> FUNCTOR;
+static unordered_map<int64_t,int> FUNCTOR_ID;
+static int atom(const string& name) {
+  auto it = ATOM_ID.find(name);
+  if (it != ATOM_ID.end()) return it->second;
+  ATOM.push_back(name);
+  return ATOM_ID[name] = ATOM.size()-1;
+}
+static int intern(int name, int arity) {
+  int64_t key = int64_t(name)<<32 | arity;
+  auto it = FUNCTOR_ID.find(key);
+  if (it != FUNCTOR_ID.end()) return it->second;
+  FUNCTOR.push_back({name,arity,ATOM[name]+"/"+to_string(arity)});
+  return FUNCTOR_ID[key] = FUNCTOR.size()-1;
 }
-static functor lab2func(const string& lab) {
+static const cell NIL = data(CON,atom("[]"));
+static int lab2func(const string& lab) {
   for (int i = lab.size()-1; 0 <= i; i--) if (lab[i] == '/') {
-    return functor(lab.substr(0,i),int(cvt(&lab[i+1])));
+    return intern(atom(lab.substr(0,i)),atoi(&lab[i+1]));
   }
-  return functor("",0);
+  return intern(atom(""),0);
 }
-static string read_functor(istream& in) {
+static int functor_id(const string& s) {
+  static unordered_map<string,int> cache; // raw text -> functor id
+  auto it = cache.find(s);
+  if (it != cache.end()) return it->second;
+  return cache[s] = lab2func(s); // remove trailing stuff
+}
+static int read_functor(istream& in) {
   string s;
   char c = in.get();
   while (in && c == ' ') c = in.get();
@@ -106,24 +165,106 @@ static string read_functor(istream& in) {
   string tmp;
   in >> tmp;
   s += tmp;
-  return func2lab(lab2func(s)); // remove trailing stuff
-}
-struct cell {
-  data d;
-  functor f;
-  cell() : d(NAT,0), f("",0) {}
-  cell& operator=(const data& o) { d = o; f = functor("",0); }
-  bool operator==(const data& o) { return d == o; }
-  bool operator!=(const data& o) { return d != o; }
-  cell& operator=(const functor& o) { d = data(FCT,0); f = o; }
-  bool operator==(const functor& o) { return f == o; }
-  bool operator!=(const functor& o) { return f != o; }
-  operator data&() { return d; }
-  operator functor&() { return f; }
+  return functor_id(s);
+}
+
+// registers are resolved here: Xn to its address in the store, Yn to its
+// offset from E and #n (arithmetic immediates) to n. c gets the class
+static bool resolve_register(char c, int n, int& i) {
+  switch (c) {
+    case 'X': i = X0+n-1; return true;
+    case 'Y': case '#': i = n; return true;
+  }
+  return false;
+}
+static void read_register(istream& in, int& i, char& c) {
+  string s;
+  in >> s;
+  c = s[0];
+  if (!resolve_register(c,atoi(&s[1]),i)) {
+    fatal(INVALID_REGISTER,"%s",s.c_str());
+  }
+}
+
+// the operands of a line from the compiler, read like those of the text
+struct line_reader {
+  const code_line& L;
+  int r; // next register
+  line_reader& operator>>(int& n) { n = L.n; return *this; }
+  line_reader& operator>>(string& s) { s = L.text; return *this; }
+};
+static int read_functor(line_reader& in) { return functor_id(in.L.text); }
+static void read_register(line_reader& in, int& i, char& c) {
+  const code_operand& a = in.L.r[in.r++];
+  c = a.c;
+  if (!resolve_register(c,a.n,i)) fatal(INVALID_REGISTER,"%c%d",c,a.n);
+}
+
+// code: fixed-width bytecode with pre-decoded operands
+struct instr {
+  const void* h; // handler address, for direct threading
+  int op;
+  int k;         // functor or atom id, or code address
+  int n;         // integer operand
+  int i,j;       // register operands
+  char ci,cj;    // their classes
+};
+#define MAXC  (1<<24)
+#define LINK0 (MAXC/4*3) // code built by link() goes in [LINK0,MAXC)
+static instr* const CODE = reserve<instr>(MAXC,"code");
+static int CODE_SIZE = 0, LINK_SIZE = LINK0;
+static int UNLINKED = 0; // code from here on is new since the last link
+static int P, CP; // instruction pointers
+static map<int,cell> KEY; // first argument of the clause at each entry point
+static void free_code(int beg = 0) {
+  while (beg < CODE_SIZE) CODE[--CODE_SIZE] = instr();
+  KEY.erase(KEY.lower_bound(beg),KEY.end());
+}
+// procedures, by functor id. call sites are resolved to these by link()
+struct procedure {
+  int entry = -1;          // where calls jump to. -1 if there are no clauses
+  int Lv, Lc, Ll, Ls;      // switch_on_term targets
+  int size = 0;            // of its code in the link area
+  int Sc = -1, Ss = -1;    // its switch tables, if any
+};
+static vector<procedure> PROC;
+static set<string> STALE; // labels whose clauses changed since the last link
+static int LINK_GARBAGE = 0; // link area code of relinked procedures
+static bool LINK_VERBOSE = false;
+
+// the query is run from its label and never called, so it isn't linked
+static void touch(const string& label) {
+  if (label != "query") STALE.insert(label);
+}
+
+static void free_query() {
+  free_code(symbol_table["query"][0].P);
+  symbol_table.erase("query");
+}
+
+// first argument index: key cell -> entry point of the matching clauses.
+// small tables are scanned, large ones are hashed
+#define SMALL_SWITCH 8
+struct switch_table {
+  vector<pair<cell,int>> small;
+  unordered_map<cell,int> large;
+  int miss; // entry point for the other keys
+  void insert(cell key, int L) {
+    if (small.size() < SMALL_SWITCH) small.emplace_back(key,L);
+    else large[key] = L;
+  }
+  int operator[](cell key) const {
+    for (auto& kv : small) if (kv.first == key) return kv.second;
+    if (large.empty()) return miss;
+    auto it = large.find(key);
+    return it == large.end() ? miss : it->second;
+  }
 };
+static vector<switch_table> SWITCH;
+static vector<int> FREE_SWITCH; // tables of relinked procedures, for reuse
 
 // memory
-static cell STORE[MAXN];
+static cell* STORE;
 
 // heap
 struct {
@@ -131,42 +272,66 @@ struct {
 } static HEAP;
 static int H, S, HB; // pointers
 
-// stack
+// environment stack, in the store above the heap. an environment is one
+// cell with its continuation, then its permanent variables: Yn is at E+n
+struct env {
+  int CE, CP;
+};
 struct {
-  int CE,CP,n;
-  int YA; // custom: offset for local vars/args
-  int nxtYA() const { // compute Y offset for env/choice on top of this one
-    return YA+n;
-  }
-  
-  // for choice points only
-  int B,BP,TR,H;
-  string L; // custom: address label
-  int NC;   // custom: index of next clause. symbol_table[L][NC].P == BP
-} static STACK[MAXN];
-static int E, B; // pointers
-
-// registers
-typedef pair<char,int> reg;
-static reg read_register(istream& in) {
-  string s;
-  in >> s;
-  return reg(s[0],int(cvt(&s[1])));
-}
+  env& operator[](int e) { return *(env*)&STORE[e]; }
+} static ENV;
+static int E; // -1 if none
+
+// choice point stack, apart from the store. a choice point is a header,
+// then a copy of the first n argument registers
+struct choice {
+  int B;      // previous choice point
+  int CE, CP; // continuation
+  int BP;     // next alternative
+  int TR, H;
+  int ET;     // environment stack top, kept for backtracking
+  int n;
+};
+#define CHOICE_CELLS int(sizeof(choice)/sizeof(cell))
+static cell* CHOICE_STACK;
 struct {
-  cell& operator[](const reg& i) { return STORE[addr(i)]; }
-  int addr(const reg& i) {
-    switch (i.first) {
-      case 'X': return X0+i.second-1;           // global registers
-      case 'Y': return STACK[E].YA+i.second-1;  // stack local variables
-      case 'A': return STACK[B].YA+i.second-1;  // stack arguments
-    }
-    fatal(INVALID_REGISTER,"%c%d",i.first,i.second);
-  }
-} static X;
+  choice& operator[](int b) { return *(choice*)&CHOICE_STACK[b]; }
+  cell* args(int b) { return &CHOICE_STACK[b+CHOICE_CELLS]; }
+} static CHOICE;
+static int B;  // offset of the newest choice point, -1 if none
+static int B0; // cut barrier: B when the current procedure was called
+
+// top of the environment stack. an environment is trimmed to the variables
+// still live at its current call, which the call instruction before CP
+// holds. the environments below the newest choice point stay
+static int env_top() {
+  int top = E == -1 ? YA0 : E+1+CODE[CP-1].n;
+  return B == -1 ? top : max(top,CHOICE[B].ET);
+}
+
+// register operand classes. instructions with register operands have one
+// variant for each class of each operand, chosen by the assembler
+struct XR { // global registers
+  static const bool permanent = false;
+  static int addr(int i) { return i; }
+  static cell& at(int i) { return STORE[i]; }
+};
+struct YR { // stack local variables
+  static const bool permanent = true;
+  static int addr(int i) { return E+i; }
+  static cell& at(int i) { return STORE[E+i]; }
+};
+#define VARIANTS1(N) \
+  struct N##_x : N<XR> {}; \
+  struct N##_y : N<YR> {};
+#define VARIANTS2(N) \
+  struct N##_xx : N<XR,XR> {}; \
+  struct N##_xy : N<XR,YR> {}; \
+  struct N##_yx : N<YR,XR> {}; \
+  struct N##_yy : N<YR,YR> {};
 
 // trail
-static int TRAIL[MAXN], TR;
+static int *TRAIL, TR;
 
 // mode
 enum wam_mode {
@@ -179,7 +344,7 @@ static wam_mode mode;
 static bool halt, fail;
 
 // query variables
-static vector<pair<string,reg>> query_vars;
+static vector<pair<string,int>> query_vars; // names and addresses
 static map<int,string> query_unbound_vars;
 static void clear_query() { query_vars.clear(); query_unbound_vars.clear(); }
 
@@ -187,22 +352,112 @@ static void clear_query() { query_vars.clear(); query_unbound_vars.clear(); }
 // machine functions
 // =============================================================================
 
-// for injection of choice instructions
-static void call_try_me_else(istream&);
-static void call_retry_me_else(istream&);
-static void call_trust_me(istream&);
+// numbers while they are evaluated. integers are int64_t until they overflow
+struct number {
+  enum { INTEGER, FLOAT, BIG } kind;
+  int64_t i;
+  double f;
+  bignum b;
+};
+static number integer(const bignum& b) {
+  number x;
+  x.kind = b.to_int64(x.i) ? number::INTEGER : number::BIG;
+  if (x.kind == number::BIG) x.b = b;
+  return x;
+}
+
+// the cell of a number. only numbers that do not fit an INT cell are boxed,
+// at STORE[top]
+static cell make_number(const number& x, int& top) {
+  int a = top;
+  if (x.kind == number::INTEGER) {
+    if (val_of(data(INT,x.i)) == x.i) return data(INT,x.i);
+    STORE[a] = box_header(BOX_INT64,1);
+    STORE[a+1] = uint64_t(x.i);
+  }
+  else if (x.kind == number::FLOAT) {
+    STORE[a] = box_header(BOX_FLOAT,1);
+    memcpy(&STORE[a+1],&x.f,sizeof(double));
+  }
+  else {
+    int n = (x.b.mag.size()+1)/2;
+    STORE[a] = box_header(x.b.neg ? BOX_NEG_BIG : BOX_BIG,n);
+    for (int i = 0; i < n; i++) {
+      uint64_t hi = (2*i+1 < x.b.mag.size() ? x.b.mag[2*i+1] : 0);
+      STORE[a+1+i] = hi<<32 | x.b.mag[2*i];
+    }
+  }
+  top = a+1+box_size(STORE[a]);
+  return data(NUM,a);
+}
+
+static bool get_number(cell c, number& x) {
+  if (tag_of(c) == INT) {
+    x.kind = number::INTEGER;
+    x.i = val_of(c);
+    return true;
+  }
+  if (tag_of(c) != NUM) return false;
+  int a = val_of(c);
+  cell h = STORE[a];
+  switch (box_kind(h)) {
+    case BOX_INT64: x.kind = number::INTEGER; x.i = STORE[a+1]; break;
+    case BOX_FLOAT:
+      x.kind = number::FLOAT;
+      memcpy(&x.f,&STORE[a+1],sizeof(double));
+      break;
+    default:
+      x.kind = number::BIG;
+      x.b.neg = (box_kind(h) == BOX_NEG_BIG);
+      x.b.mag.clear();
+      for (int i = 1; i <= box_size(h); i++) {
+        x.b.mag.push_back(uint32_t(STORE[a+i]));
+        x.b.mag.push_back(uint32_t(STORE[a+i]>>32));
+      }
+      while (!x.b.mag.back()) x.b.mag.pop_back();
+  }
+  return true;
+}
+
+// numbers are equal if their cells or their boxes are
+static bool same_constant(cell c1, cell c2) {
+  if (c1 == c2) return true;
+  if (tag_of(c1) != NUM || tag_of(c2) != NUM) return false;
+  int a1 = val_of(c1), a2 = val_of(c2);
+  for (int i = 0; i <= box_size(STORE[a1]); i++) {
+    if (STORE[a1+i] != STORE[a2+i]) return false;
+  }
+  return true;
+}
+
+static string number_text(cell c) {
+  number x;
+  get_number(c,x);
+  if (x.kind == number::BIG) return x.b.str();
+  if (x.kind == number::INTEGER) return to_string(x.i);
+  char buf[32];
+  snprintf(buf,sizeof(buf),"%.15g",x.f);
+  string s = buf;
+  if (s.find_first_not_of("-0123456789") == string::npos) s += ".0";
+  return s;
+}
 
 static int deref(int a) {
-  data tmp = STORE[a];
-  while (tmp.first == REF && tmp.second != a) {
-    a = tmp.second;
+  cell tmp = STORE[a];
+  while (tag_of(tmp) == REF && val_of(tmp) != a) {
+    a = val_of(tmp);
     tmp = STORE[a];
   }
   return a;
 }
 
+// only bindings older than the newest choice point are undone
+static bool must_trail(int a) {
+  return B != -1 && (a < HB || (YA0 <= a && a < CHOICE[B].ET));
+}
+
 static void trail(int a) {
-  if (a < HB || (H < a && a < B)) {
+  if (must_trail(a)) {
     TRAIL[TR] = a;
     TR = TR+1;
   }
@@ -213,13 +468,13 @@ static void unwind_trail(int a1, int a2) {
 }
 
 static void bind(int a1, int a2) {
-  tag t1 = STORE[a1].d.first, t2 = STORE[a2].d.first;
+  tag t1 = tag_of(STORE[a1]), t2 = tag_of(STORE[a2]);
   if (t1 == REF && (t2 != REF || a2 < a1)) STORE[a1] = STORE[a2], trail(a1);
   else STORE[a2] = STORE[a1], trail(a2);
 }
 
+static int* PDL; // two addresses for each pair of cells still to unify
 static void unify(int a1, int a2) {
-  static int PDL[MAXN];
   int size = 0;
   auto push = [&](int x) { PDL[size++] = x; };
   auto pop = [&]() { return PDL[--size]; };
@@ -228,105 +483,261 @@ static void unify(int a1, int a2) {
   while (!empty()) {
     int d1 = deref(pop()); int d2 = deref(pop());
     if (d1 == d2) continue;
-    tag t1 = STORE[d1].d.first; int v1 = STORE[d1].d.second;
-    tag t2 = STORE[d2].d.first; int v2 = STORE[d2].d.second;
+    cell c1 = STORE[d1], c2 = STORE[d2];
+    tag t1 = tag_of(c1), t2 = tag_of(c2);
     if (t1 == REF || t2 == REF) { bind(d1,d2); continue; }
-    const functor& f1 = STORE[v1]; const functor& f2 = STORE[v2];
-    if (f1 != f2) { fail = true; break; }
-    for (int i = 1; i <= f1.second; i++) { push(v1+i); push(v2+i); }
+    if (t1 != t2) { fail = true; break; }
+    int v1 = val_of(c1), v2 = val_of(c2);
+    switch (t1) {
+      case STR: {
+        if (STORE[v1] != STORE[v2]) { fail = true; break; }
+        int n = FUNCTOR[val_of(STORE[v1])].arity;
+        for (int i = 1; i <= n; i++) { push(v1+i); push(v2+i); }
+        break;
+      }
+      case LIS: { push(v1); push(v2); push(v1+1); push(v2+1); break; }
+      default: if (!same_constant(c1,c2)) fail = true;
+    }
+    if (fail) break;
   }
 }
 
-static int next_clause(const string& label, int first = 0) {
-  if (!symbol_table.count(label)) return -1;
-  const auto& clauses = symbol_table[label];
-  while (first < clauses.size() && !clauses[first].on) first++;
-  if (first == clauses.size()) return -1;
-  return first;
+// drop the choice points newer than b. their trail entries are kept only if
+// the binding is still older than the new newest choice point
+static void cut_to(int b) {
+  if (B <= b) return;
+  B = b;
+  int tr = 0;
+  if (B != -1) HB = CHOICE[B].H, tr = CHOICE[B].TR;
+  for (int i = tr; i < TR; i++) {
+    if (must_trail(TRAIL[i])) TRAIL[tr++] = TRAIL[i];
+  }
+  TR = tr;
 }
 
 static void backtrack() {
-  P = STACK[B].BP;
-  // retry_me_else and trust_me injection for multi-clause definitions
-  P = P-1;
-  int nxt = next_clause(STACK[B].L,STACK[B].NC+1);
-  stringstream ss;
-  ss << nxt;
-  if (nxt >= 0) call_retry_me_else(ss);
-  else call_trust_me(ss); // nxt is not used here!
+  P = CHOICE[B].BP; // retry_clause or trust_clause of the next alternative
+}
+
+// =============================================================================
+// garbage collection
+// =============================================================================
+
+// sliding mark-compact collection of the heap. it runs at calls, where only
+// the argument registers are live. the roots are those registers, the live
+// variables of every environment still reachable, the arguments saved in
+// choice points and the trail. live cells keep their order, so bindings
+// still go from younger to older cells and the saved H of each choice point
+// still splits the heap where it did
+static struct {
+  int percent = 100; // of the heap, after which it is collected
+  int limit;         // H past which it is, raised while live cells are over
+  bool verbose = false;
+  int collections = 0;
+  long long reclaimed = 0;
+  double seconds = 0;
+} GC;
+
+static int gc_watermark() {
+  return H0+int64_t(HN-H0)*GC.percent/100;
+}
+
+static void collect(int n) {
+  clock_t start = clock();
+  int size = H-H0;
+  // roots: argument registers, environment variables live at their
+  // continuations, choice point arguments. an environment met again only
+  // adds the variables live at the other continuation
+  vector<cell*> roots;
+  unordered_map<int,int> seen;
+  for (int i = 0; i < n; i++) roots.push_back(&STORE[X0+i]);
+  auto walk = [&](int e, int cp) {
+    for (; e != -1; cp = ENV[e].CP, e = ENV[e].CE) {
+      int m = CODE[cp-1].n, old = seen.count(e) ? seen[e] : -1;
+      for (int i = max(old,0)+1; i <= m; i++) roots.push_back(&STORE[e+i]);
+      seen[e] = max(old,m);
+      if (old != -1) break;
+    }
+  };
+  walk(E,CP);
+  for (int b = B; b != -1; b = CHOICE[b].B) {
+    for (int i = 0; i < CHOICE[b].n; i++) roots.push_back(CHOICE.args(b)+i);
+    walk(CHOICE[b].CE,CHOICE[b].CP);
+  }
+  // mark. boxed numbers are marked whole, their raw words are not followed
+  vector<char> live(size);
+  vector<int> todo;
+  auto mark = [&](int a) {
+    if (H0 <= a && a < H && !live[a-H0]) live[a-H0] = 1, todo.push_back(a);
+  };
+  auto follow = [&](cell c) {
+    int v = val_of(c);
+    switch (tag_of(c)) {
+      case REF: mark(v); break;
+      case STR:
+        mark(v);
+        for (int i = 1; i <= FUNCTOR[val_of(HEAP[v])].arity; i++) mark(v+i);
+        break;
+      case LIS: mark(v); mark(v+1); break;
+      case NUM:
+        if (H0 <= v && v < H && !live[v-H0]) {
+          for (int i = 0; i <= box_size(HEAP[v]); i++) live[v-H0+i] = 1;
+        }
+        break;
+      default: break;
+    }
+  };
+  for (cell* r : roots) follow(*r);
+  for (int i = 0; i < TR; i++) mark(TRAIL[i]);
+  while (!todo.empty()) {
+    int a = todo.back();
+    todo.pop_back();
+    follow(HEAP[a]);
+  }
+  // new addresses: the live cells below each one
+  vector<int> fwd(size+1);
+  for (int i = 0; i < size; i++) fwd[i+1] = fwd[i]+live[i];
+  auto forward = [&](cell c) {
+    tag t = tag_of(c);
+    int v = val_of(c);
+    if (t != REF && t != STR && t != LIS && t != NUM) return c;
+    return H0 <= v && v < H ? data(t,H0+fwd[v-H0]) : c;
+  };
+  for (cell* r : roots) *r = forward(*r);
+  for (int i = 0; i < TR; i++) {
+    if (H0 <= TRAIL[i] && TRAIL[i] < H) TRAIL[i] = H0+fwd[TRAIL[i]-H0];
+  }
+  for (int b = B; b != -1; b = CHOICE[b].B) {
+    CHOICE[b].H = H0+fwd[CHOICE[b].H-H0];
+  }
+  HB = H0+fwd[HB-H0];
+  // slide
+  for (int a = H0; a < H; a++) if (live[a-H0]) {
+    cell c = HEAP[a];
+    if (tag_of(c) != NAT) HEAP[H0+fwd[a-H0]] = forward(c);
+    else {
+      for (int i = 0; i <= box_size(c); i++) HEAP[H0+fwd[a-H0]+i] = HEAP[a+i];
+      a += box_size(c);
+    }
+  }
+  H = H0+fwd[size];
+  // statistics
+  GC.collections++;
+  GC.reclaimed += size-fwd[size];
+  double t = double(clock()-start)/CLOCKS_PER_SEC;
+  GC.seconds += t;
+  if (GC.verbose) fprintf(
+    stderr,
+    "gc: %d cells live, %d reclaimed, %.3f ms\n",
+    fwd[size],
+    size-fwd[size],
+    t*1000
+  );
+  // live cells above the watermark would make every call collect
+  GC.limit = max(gc_watermark(),H+(HN-H)/2);
 }
 
 // =============================================================================
 // L0 query instructions
 // =============================================================================
 
-struct put_structure : instruction {
-  functor f_n;
-  reg i;
-  put_structure(istream& in) {
-    f_n = lab2func(read_functor(in));
-    i = read_register(in);
+template<class R> struct put_structure {
+  template<class In> static void assemble(In& in, instr& I) {
+    I.k = read_functor(in);
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
+  static void run(const instr& I) {
     HEAP[H] = data(STR,H+1);
-    HEAP[H+1] = f_n;
-    X[i] = HEAP[H];
+    HEAP[H+1] = data(FCT,I.k);
+    R::at(I.i) = HEAP[H];
     H = H+2;
     P = P+1;
   }
 };
+VARIANTS1(put_structure)
 
-struct set_variable : instruction {
-  reg i;
-  set_variable(istream& in) {
-    i = read_register(in);
+template<class R> struct set_variable {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
+  static void run(const instr& I) {
     HEAP[H] = data(REF,H);
-    X[i] = HEAP[H];
+    R::at(I.i) = HEAP[H];
     H = H+1;
     P = P+1;
   }
 };
+VARIANTS1(set_variable)
 
-struct set_value : instruction {
-  reg i;
-  set_value(istream& in) {
-    i = read_register(in);
+template<class R> struct set_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
-    HEAP[H] = X[i];
+  static void run(const instr& I) {
+    HEAP[H] = R::at(I.i);
     H = H+1;
     P = P+1;
   }
 };
+VARIANTS1(set_value)
+
+struct set_void {
+  template<class In> static void assemble(In& in, instr& I) {
+    in >> I.n;
+  }
+  static void run(const instr& I) {
+    for (int i = 0; i < I.n; i++) HEAP[H+i] = data(REF,H+i);
+    H = H+I.n;
+    P = P+1;
+  }
+};
+
+// unbound environment variables must not be referenced from the heap
+static void globalize(int a) {
+  a = deref(a);
+  if (tag_of(STORE[a]) == REF && YA0 <= a) {
+    HEAP[H] = data(REF,H);
+    bind(a,H);
+  }
+  else HEAP[H] = STORE[a];
+  H = H+1;
+}
+
+template<class R> struct set_local_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    globalize(R::addr(I.i));
+    P = P+1;
+  }
+};
+VARIANTS1(set_local_value)
 
 // =============================================================================
 // L0 program instructions
 // =============================================================================
 
-struct get_structure : instruction {
-  functor f_n;
-  reg i;
-  get_structure(istream& in) {
-    f_n = lab2func(read_functor(in));
-    i = read_register(in);
+template<class R> struct get_structure {
+  template<class In> static void assemble(In& in, instr& I) {
+    I.k = read_functor(in);
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
-    int addr = deref(X.addr(i));
-    const data& tmp = STORE[addr];
-    switch (tmp.first) {
+  static void run(const instr& I) {
+    int addr = deref(R::addr(I.i));
+    cell tmp = STORE[addr];
+    switch (tag_of(tmp)) {
       case REF: {
         HEAP[H] = data(STR,H+1);
-        HEAP[H+1] = f_n;
+        HEAP[H+1] = data(FCT,I.k);
         bind(addr,H);
         H = H+2;
         mode = WRITE;
         break;
       }
       case STR: {
-        int a = tmp.second;
-        if (HEAP[a] == f_n) {
+        int a = val_of(tmp);
+        if (HEAP[a] == data(FCT,I.k)) {
           S = a+1;
           mode = READ;
         }
@@ -338,73 +749,104 @@ struct get_structure : instruction {
     P = P+1;
   }
 };
+VARIANTS1(get_structure)
 
-struct unify_variable : instruction {
-  reg i;
-  unify_variable(istream& in) {
-    i = read_register(in);
+template<class R> struct unify_variable {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
-    if (mode == READ) X[i] = HEAP[S];
+  static void run(const instr& I) {
+    if (mode == READ) R::at(I.i) = HEAP[S];
     else {
       HEAP[H] = data(REF,H);
-      X[i] = HEAP[H];
+      R::at(I.i) = HEAP[H];
       H = H+1;
     }
     S = S+1;
     P = P+1;
   }
 };
+VARIANTS1(unify_variable)
 
-struct unify_value : instruction {
-  reg i;
-  unify_value(istream& in) {
-    i = read_register(in);
+template<class R> struct unify_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
-    if (mode == READ) unify(X.addr(i),S);
+  static void run(const instr& I) {
+    if (mode == READ) unify(R::addr(I.i),S);
     else {
-      HEAP[H] = X[i];
+      HEAP[H] = R::at(I.i);
       H = H+1;
     }
     S = S+1;
     P = P+1;
   }
 };
+VARIANTS1(unify_value)
+
+template<class R> struct unify_local_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    if (mode == READ) unify(R::addr(I.i),S);
+    else globalize(R::addr(I.i));
+    S = S+1;
+    P = P+1;
+  }
+};
+VARIANTS1(unify_local_value)
+
+// n anonymous variables: skipped when matching, fresh cells when building
+struct unify_void {
+  template<class In> static void assemble(In& in, instr& I) {
+    in >> I.n;
+  }
+  static void run(const instr& I) {
+    if (mode == WRITE) {
+      for (int i = 0; i < I.n; i++) HEAP[H+i] = data(REF,H+i);
+      H = H+I.n;
+    }
+    S = S+I.n;
+    P = P+1;
+  }
+};
 
 // =============================================================================
 // L1 control instructions
 // =============================================================================
 
-struct call : instruction {
-  string L;
-  call(istream& in) {
-    L = read_functor(in);
+// n is the number of permanent variables still live after the call
+struct call {
+  template<class In> static void assemble(In& in, instr& I) {
+    I.k = read_functor(in);
+    in >> I.n;
   }
-  void run() const {
-    int fst = next_clause(L,0);
-    if (fst < 0) {
-      fail = true;
-      printf("procedure %s not defined. backtracking.\n",L.c_str());
-    }
-    else {
-      CP = P+1;
-      P = symbol_table[L][fst].P;
-      int nxt = next_clause(L,fst+1);
-      // try_me_else injection for multi-clause definitions
-      if (nxt > fst) {
-        P = P-1;
-        stringstream ss;
-        ss << L << " " << nxt;
-        call_try_me_else(ss);
-      }
-    }
+  static void run(const instr& I) {
+    CP = P+1;
+    B0 = B;
+    if (H > GC.limit) collect(FUNCTOR[I.k].arity);
+    P = PROC[I.k].entry;
+    if (P < 0) fail = true;
+  }
+};
+
+// last call: the caller's environment is already gone, CP is kept
+struct execute {
+  template<class In> static void assemble(In& in, instr& I) {
+    I.k = read_functor(in);
+  }
+  static void run(const instr& I) {
+    B0 = B;
+    if (H > GC.limit) collect(FUNCTOR[I.k].arity);
+    P = PROC[I.k].entry;
+    if (P < 0) fail = true;
   }
 };
 
-struct proceed : instruction {
-  proceed(istream&) {}
-  void run() const {
+struct proceed {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
     P = CP;
   }
 };
@@ -413,87 +855,113 @@ struct proceed : instruction {
 // L1 query instructions
 // =============================================================================
 
-struct put_variable : instruction {
-  reg n,i;
-  put_variable(istream& in) {
-    n = read_register(in);
-    i = read_register(in);
+template<class R1, class R2> struct put_variable {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
   }
-  void run() const {
-    HEAP[H] = data(REF,H);
-    X[n] = HEAP[H];
-    X[i] = HEAP[H];
-    H = H+1;
+  static void run(const instr& I) {
+    if (R1::permanent) { // unbound variable in the environment
+      int a = R1::addr(I.i);
+      STORE[a] = data(REF,a);
+      R2::at(I.j) = STORE[a];
+    }
+    else {
+      HEAP[H] = data(REF,H);
+      R1::at(I.i) = HEAP[H];
+      R2::at(I.j) = HEAP[H];
+      H = H+1;
+    }
     P = P+1;
   }
 };
+VARIANTS2(put_variable)
 
-struct put_value : instruction {
-  reg n,i;
-  put_value(istream& in) {
-    n = read_register(in);
-    i = read_register(in);
+template<class R1, class R2> struct put_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
   }
-  void run() const {
-    X[i] = X[n];
+  static void run(const instr& I) {
+    R2::at(I.j) = R1::at(I.i);
+    P = P+1;
+  }
+};
+VARIANTS2(put_value)
+
+// last occurrence of a variable first met in put_variable Yn. the
+// environment is about to be trimmed or deallocated
+template<class R1, class R2> struct put_unsafe_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
+  }
+  static void run(const instr& I) {
+    int a = deref(R1::addr(I.i));
+    if (tag_of(STORE[a]) == REF && E < a) {
+      HEAP[H] = data(REF,H);
+      bind(a,H);
+      H = H+1;
+    }
+    R2::at(I.j) = STORE[a];
     P = P+1;
   }
 };
+VARIANTS2(put_unsafe_value)
 
 // =============================================================================
 // L1 program instructions
 // =============================================================================
 
-struct get_variable : instruction {
-  reg n,i;
-  get_variable(istream& in) {
-    n = read_register(in);
-    i = read_register(in);
+template<class R1, class R2> struct get_variable {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
   }
-  void run() const {
-    X[n] = X[i];
+  static void run(const instr& I) {
+    R1::at(I.i) = R2::at(I.j);
     P = P+1;
   }
 };
+VARIANTS2(get_variable)
 
-struct get_value : instruction {
-  reg n,i;
-  get_value(istream& in) {
-    n = read_register(in);
-    i = read_register(in);
+template<class R1, class R2> struct get_value {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
   }
-  void run() const {
-    unify(X.addr(n),X.addr(i));
+  static void run(const instr& I) {
+    unify(R1::addr(I.i),R2::addr(I.j));
     P = P+1;
   }
 };
+VARIANTS2(get_value)
 
 // =============================================================================
 // L2 control instructions
 // =============================================================================
 
-struct allocate : instruction {
-  int N;
-  allocate(istream& in) {
-    in >> N;
+struct allocate {
+  template<class In> static void assemble(In& in, instr& I) {
+    in >> I.n;
   }
-  void run() const {
-    int EB = max(E,B);
-    int newE = EB+1;
-    STACK[newE].CE = E;
-    STACK[newE].CP = CP;
-    STACK[newE].n = N;
-      STACK[newE].YA = (EB == -1 ? YA0 : STACK[EB].nxtYA()); // AFTER field n
+  static void run(const instr& I) {
+    int newE = env_top();
+    ENV[newE].CE = E;
+    ENV[newE].CP = CP;
     E = newE; // "the" push
+    // the collector reads live variables before their first put_variable
+    for (int i = 1; i <= I.n; i++) STORE[E+i] = data(NAT,0);
     P = P+1;
   }
 };
 
-struct deallocate : instruction {
-  deallocate(istream&) {}
-  void run() const {
-    P = STACK[E].CP;
-    E = STACK[E].CE; // "the" pop
+struct deallocate {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
+    CP = ENV[E].CP;
+    E = ENV[E].CE; // "the" pop
+    P = P+1;
   }
 };
 
@@ -501,102 +969,594 @@ struct deallocate : instruction {
 // L3 choice instructions
 // =============================================================================
 
-struct try_me_else : instruction {
-  string L;
-  int NC;
-  try_me_else(istream& in) {
-    L = read_functor(in);
-    in >> NC;
-  }
-  void run() const {
-    int EB = max(E,B);
-    int newB = EB+1;
-    STACK[newB].n = lab2func(L).second;
-      STACK[newB].YA = (EB == -1 ? YA0 : STACK[EB].nxtYA()); // AFTER field n
-    STACK[newB].CE = E;
-    STACK[newB].CP = CP;
-    STACK[newB].B = B;
-      STACK[newB].L = L;
-      STACK[newB].NC = NC;
-    STACK[newB].BP = symbol_table[ STACK[newB].L ][ STACK[newB].NC ].P;
-    STACK[newB].TR = TR;
-    STACK[newB].H = H;
-    int n = STACK[newB].n;
+// built by link() for lists of two or more alternative clauses of a
+// procedure of arity n: try_clause C1, retry_clause C2, ..., trust_clause Cm.
+// each one runs its clause (k) with BP at the instruction after it
+
+struct try_clause {
+  static void run(const instr& I) {
+    int newB = B == -1 ? 0 : B+CHOICE_CELLS+CHOICE[B].n;
+    choice& ch = CHOICE[newB];
+    ch.B = B;
+    ch.CE = E;
+    ch.CP = CP;
+    ch.BP = P+1;
+    ch.TR = TR;
+    ch.H = H;
+    ch.ET = env_top();
+    ch.n = I.n;
+    memcpy(CHOICE.args(newB),&STORE[X0],I.n*sizeof(cell));
     B = newB; // "the" push
-    for (int i = 1; i <= n; i++) X[reg('A',i)] = X[reg('X',i)]; // AFTER B=newB
     HB = H;
+    P = I.k;
+  }
+};
+
+struct retry_clause {
+  static void run(const instr& I) {
+    choice& ch = CHOICE[B];
+    memcpy(&STORE[X0],CHOICE.args(B),ch.n*sizeof(cell));
+    E = ch.CE;
+    CP = ch.CP;
+    ch.BP = P+1;
+    unwind_trail(ch.TR,TR);
+    TR = ch.TR;
+    H = ch.H;
+    HB = H;
+    B0 = ch.B; // the barrier of the call, for cuts in this clause
+    P = I.k;
+  }
+};
+
+struct trust_clause {
+  static void run(const instr& I) {
+    const choice& ch = CHOICE[B];
+    memcpy(&STORE[X0],CHOICE.args(B),ch.n*sizeof(cell));
+    E = ch.CE;
+    CP = ch.CP;
+    unwind_trail(ch.TR,TR);
+    TR = ch.TR;
+    H = ch.H;
+    B0 = B = ch.B; // "the" pop
+    if (B != -1) HB = CHOICE[B].H;
+    P = I.k;
+  }
+};
+
+// =============================================================================
+// cut instructions
+// =============================================================================
+
+// cut before any call of the clause, while B0 still holds its barrier
+struct neck_cut {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
+    cut_to(B0);
     P = P+1;
   }
 };
-static void call_try_me_else(istream& in) { try_me_else(in).run(); }
 
-struct retry_me_else : instruction {
-  int NC;
-  retry_me_else(istream& in) {
-    in >> NC;
+// save the barrier for cuts after calls
+template<class R> struct get_level {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
   }
-  void run() const {
-    int n = STACK[B].n;
-    for (int i = 1; i <= n; i++) X[reg('X',i)] = X[reg('A',i)];
-    E = STACK[B].CE;
-    CP = STACK[B].CP;
-      STACK[B].NC = NC;
-    STACK[B].BP = symbol_table[ STACK[B].L ][ STACK[B].NC ].P;
-    unwind_trail(STACK[B].TR,TR);
-    TR = STACK[B].TR;
-    H = STACK[B].H;
-    HB = H;
+  static void run(const instr& I) {
+    R::at(I.i) = data(INT,B0);
     P = P+1;
   }
 };
-static void call_retry_me_else(istream& in) { retry_me_else(in).run(); }
+VARIANTS1(get_level)
 
-struct trust_me : instruction {
-  trust_me(istream&) {}
-  void run() const {
-    int n = STACK[B].n;
-    for (int i = 1; i <= n; i++) X[reg('X',i)] = X[reg('A',i)];
-    E = STACK[B].CE;
-    CP = STACK[B].CP;
-    unwind_trail(STACK[B].TR,TR);
-    TR = STACK[B].TR;
-    H = STACK[B].H;
-    B = STACK[B].B; // "the" pop
-    if (B != -1) HB = STACK[B].H;
+template<class R> struct cut {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    cut_to(val_of(R::at(I.i)));
     P = P+1;
   }
 };
-static void call_trust_me(istream& in) { trust_me(in).run(); }
+VARIANTS1(cut)
+
+// =============================================================================
+// constant instructions
+// =============================================================================
+
+// literal pool: constants that do not fit the instruction, by text
+static unordered_map<string,int> LITERAL;
+static int LIT_SIZE = LIT0;
+static int literal(const string& s) {
+  auto it = LITERAL.find(s);
+  if (it != LITERAL.end()) return it->second;
+  number x;
+  if (s.find_first_of(".eE") == string::npos) x = integer(bignum::parse(s));
+  else x.kind = number::FLOAT, x.f = strtod(s.c_str(),nullptr);
+  int L = LIT_SIZE++;
+  STORE[L] = make_number(x,LIT_SIZE);
+  if (H0 < LIT_SIZE) fatal(LITERAL_OVERFLOW,"%s",s.c_str());
+  return LITERAL[s] = L;
+}
+
+// an atom, maybe quoted, a number or a functor label
+static string read_text(istream& in) {
+  string s, tmp;
+  if ((in >> ws).peek() == '\'') {
+    s += in.get();
+    getline(in,tmp,'\'');
+    s += tmp+'\'';
+    tmp.clear(); // kept if nothing follows
+  }
+  in >> tmp;
+  s += tmp;
+  if (!s.empty() && s.back() == ',') s.pop_back();
+  return s;
+}
+
+// k holds the value and n the tag (CON: atom id), or n is NAT and k the
+// address of the constant in the literal pool
+static void text_constant(const string& s, instr& I) {
+  if (!isdigit(s[s[0] == '-'])) {
+    I.k = atom(s);
+    I.n = CON;
+    return;
+  }
+  char* end;
+  long long v = strtoll(s.c_str(),&end,10);
+  if (!*end && v == int(v)) I.k = v, I.n = INT;
+  else I.k = literal(s), I.n = NAT;
+}
+static void read_constant(istream& in, instr& I) {
+  text_constant(read_text(in),I);
+}
+static void read_constant(line_reader& in, instr& I) {
+  text_constant(in.L.text,I);
+}
+static cell constant(const instr& I) {
+  if (I.n == NAT) return STORE[I.k];
+  return data(tag(I.n),I.k);
+}
+
+static void match_constant(int a, cell c) {
+  a = deref(a);
+  if (tag_of(STORE[a]) == REF) {
+    STORE[a] = c;
+    trail(a);
+  }
+  else if (!same_constant(STORE[a],c)) fail = true;
+}
+
+template<class R> struct put_constant {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_constant(in,I);
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    R::at(I.i) = constant(I);
+    P = P+1;
+  }
+};
+VARIANTS1(put_constant)
+
+template<class R> struct get_constant {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_constant(in,I);
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    match_constant(R::addr(I.i),constant(I));
+    P = P+1;
+  }
+};
+VARIANTS1(get_constant)
+
+struct set_constant {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_constant(in,I);
+  }
+  static void run(const instr& I) {
+    HEAP[H] = constant(I);
+    H = H+1;
+    P = P+1;
+  }
+};
+
+struct unify_constant {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_constant(in,I);
+  }
+  static void run(const instr& I) {
+    if (mode == READ) match_constant(S,constant(I));
+    else {
+      HEAP[H] = constant(I);
+      H = H+1;
+    }
+    S = S+1;
+    P = P+1;
+  }
+};
+
+// =============================================================================
+// list instructions
+// =============================================================================
+
+// a list pair is two heap cells, head and tail, and LIS cells point to it
+
+template<class R> struct put_list {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    R::at(I.i) = data(LIS,H);
+    P = P+1;
+  }
+};
+VARIANTS1(put_list)
+
+template<class R> struct get_list {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    int addr = deref(R::addr(I.i));
+    cell tmp = STORE[addr];
+    switch (tag_of(tmp)) {
+      case REF: {
+        STORE[addr] = data(LIS,H);
+        trail(addr);
+        mode = WRITE;
+        break;
+      }
+      case LIS: {
+        S = val_of(tmp);
+        mode = READ;
+        break;
+      }
+      default: fail = true;
+    }
+    P = P+1;
+  }
+};
+VARIANTS1(get_list)
+
+template<class R> struct put_nil {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    R::at(I.i) = NIL;
+    P = P+1;
+  }
+};
+VARIANTS1(put_nil)
+
+template<class R> struct get_nil {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+  }
+  static void run(const instr& I) {
+    match_constant(R::addr(I.i),NIL);
+    P = P+1;
+  }
+};
+VARIANTS1(get_nil)
+
+struct set_nil {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
+    HEAP[H] = NIL;
+    H = H+1;
+    P = P+1;
+  }
+};
+
+struct unify_nil {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
+    if (mode == READ) match_constant(S,NIL);
+    else {
+      HEAP[H] = NIL;
+      H = H+1;
+    }
+    S = S+1;
+    P = P+1;
+  }
+};
+
+// =============================================================================
+// arithmetic instructions
+// =============================================================================
+
+// operands are registers or immediates (#n). INT cells are computed in
+// place. the rest goes through number, and its results are boxed on the
+// heap only if they do not fit an INT cell. errors make the goal fail
+static bool arith_error(const char* err, const string& what) {
+  fprintf(stderr,"error (%s): %s\n",err,what.c_str());
+  fail = true;
+  return false;
+}
+
+// operands of any class: X, Y or #
+static int operand_addr(int i, char c) {
+  return c == 'Y' ? YR::addr(i) : XR::addr(i);
+}
+
+static bool small_operand(int i, char c, int64_t& v) {
+  if (c == '#') {
+    v = i;
+    return true;
+  }
+  cell x = STORE[deref(operand_addr(i,c))];
+  v = val_of(x);
+  return tag_of(x) == INT;
+}
+
+// INT cells hold 61 bits, so only products can overflow int64_t here
+static bool small_apply(int op, int64_t a, int64_t b, int64_t& v) {
+  switch (op) {
+    case '+': v = a+b; break;
+    case '-': v = a-b; break;
+    case '*':
+      if (a != int32_t(a) || b != int32_t(b)) return false;
+      v = a*b;
+      break;
+    default:
+      if (!b) return false;
+      v = a/b;
+  }
+  return val_of(data(INT,v)) == v;
+}
+
+// false on overflow
+static bool int64_apply(int op, int64_t a, int64_t b, int64_t& v) {
+  switch (op) {
+    case '+': v = int64_t(uint64_t(a)+uint64_t(b)); return ((a^v)&(b^v)) >= 0;
+    case '-': v = int64_t(uint64_t(a)-uint64_t(b)); return ((a^b)&(a^v)) >= 0;
+    case '*':
+#ifdef __GNUC__
+      return !__builtin_mul_overflow(a,b,&v);
+#else
+      if (a != int32_t(a) || b != int32_t(b)) return false;
+      v = a*b;
+      return true;
+#endif
+    default:
+      if (a == INT64_MIN && b == -1) return false;
+      v = a/b;
+      return true;
+  }
+}
+
+static double to_double(const number& x) {
+  if (x.kind == number::FLOAT) return x.f;
+  if (x.kind == number::BIG) return x.b.to_double();
+  return x.i;
+}
+static bignum to_bignum(const number& x) {
+  return x.kind == number::BIG ? x.b : bignum(x.i);
+}
+
+// floats are contagious. integers go to bignums when int64_t overflows
+static bool apply(int op, const number& a, const number& b, number& v) {
+  if (a.kind == number::FLOAT || b.kind == number::FLOAT) {
+    double x = to_double(a), y = to_double(b);
+    if (op == '/' && y == 0) {
+      return arith_error("EVALUATION_ERROR","zero divisor");
+    }
+    v.kind = number::FLOAT;
+    switch (op) {
+      case '+': v.f = x+y; break;
+      case '-': v.f = x-y; break;
+      case '*': v.f = x*y; break;
+      default:  v.f = x/y;
+    }
+    return true;
+  }
+  bignum x = to_bignum(a), y = to_bignum(b);
+  if (op == '/' && y.zero()) {
+    return arith_error("EVALUATION_ERROR","zero divisor");
+  }
+  if (a.kind == number::INTEGER && b.kind == number::INTEGER) {
+    v.kind = number::INTEGER;
+    if (int64_apply(op,a.i,b.i,v.i)) return true;
+  }
+  switch (op) {
+    case '+': v = integer(x+y); break;
+    case '-': v = integer(x-y); break;
+    case '*': v = integer(x*y); break;
+    default:  v = integer(x/y);
+  }
+  return true;
+}
+
+static int compare(const number& a, const number& b) {
+  if (a.kind == number::FLOAT || b.kind == number::FLOAT) {
+    double x = to_double(a), y = to_double(b);
+    return (x > y)-(x < y);
+  }
+  if (a.kind == number::INTEGER && b.kind == number::INTEGER) {
+    return (a.i > b.i)-(a.i < b.i);
+  }
+  return compare(to_bignum(a),to_bignum(b));
+}
+
+// the value of the expression at address a. terms built at run time are
+// evaluated too
+static bool eval(int a, number& v) {
+  static const int ADD = intern(atom("+"),2), SUB = intern(atom("-"),2);
+  static const int MUL = intern(atom("*"),2), DIV = intern(atom("/"),2);
+  cell c = STORE[a = deref(a)];
+  switch (tag_of(c)) {
+    case INT: case NUM: return get_number(c,v);
+    case REF: return arith_error("INSTANTIATION_ERROR","arithmetic");
+    case STR: {
+      int s = val_of(c), f = val_of(HEAP[s]), op = 0;
+      if (f == ADD) op = '+';
+      else if (f == SUB) op = '-';
+      else if (f == MUL) op = '*';
+      else if (f == DIV) op = '/';
+      else return arith_error("TYPE_ERROR",FUNCTOR[f].label);
+      number x, y;
+      return eval(s+1,x) && eval(s+2,y) && apply(op,x,y,v);
+    }
+    case CON: return arith_error("TYPE_ERROR",ATOM[val_of(c)]+"/0");
+    default: return arith_error("TYPE_ERROR","evaluable");
+  }
+}
+
+static bool operand(int i, char c, number& v) {
+  if (c != '#') return eval(operand_addr(i,c),v);
+  v.kind = number::INTEGER;
+  v.i = i;
+  return true;
+}
+
+// slow paths, out of the instructions
+static void arith_slow(int op, const instr& I) {
+  number x, y, v;
+  if (op) {
+    if (!operand(I.i,I.ci,x) || !operand(I.j,I.cj,y)) return;
+    if (!apply(op,x,y,v)) return;
+  }
+  else if (!operand(I.i,I.ci,v)) return;
+  STORE[I.n] = make_number(v,H);
+}
+static bool compare_slow(const instr& I, int& c) {
+  number x, y;
+  if (!operand(I.i,I.ci,x) || !operand(I.j,I.cj,y)) return false;
+  c = compare(x,y);
+  return true;
+}
+
+// evaluate Vi, Xn. n holds the address of Xn
+struct evaluate {
+  template<class In> static void assemble(In& in, instr& I) {
+    char c;
+    read_register(in,I.i,I.ci);
+    read_register(in,I.n,c);
+  }
+  static void run(const instr& I) {
+    int64_t v;
+    if (small_operand(I.i,I.ci,v)) STORE[I.n] = data(INT,v);
+    else arith_slow(0,I);
+    P = P+1;
+  }
+};
+
+// add Vi, Vj, Xn is Xn = Vi+Vj, and so on
+template<int OP> struct arithmetic {
+  template<class In> static void assemble(In& in, instr& I) {
+    char c;
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
+    read_register(in,I.n,c);
+  }
+  static void run(const instr& I) {
+    int64_t a, b, v;
+    if (small_operand(I.i,I.ci,a) && small_operand(I.j,I.cj,b) &&
+        small_apply(OP,a,b,v)) STORE[I.n] = data(INT,v);
+    else arith_slow(OP,I);
+    P = P+1;
+  }
+};
+struct add : arithmetic<'+'> {};
+struct subtract : arithmetic<'-'> {};
+struct multiply : arithmetic<'*'> {};
+struct divide : arithmetic<'/'> {};
+
+enum comparison_op { EQ, NE, LT, GT, LE, GE };
+template<comparison_op OP> struct comparison {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    read_register(in,I.j,I.cj);
+  }
+  static void run(const instr& I) {
+    int64_t a, b;
+    int c;
+    P = P+1;
+    if (small_operand(I.i,I.ci,a) && small_operand(I.j,I.cj,b)) {
+      c = (a > b)-(a < b);
+    }
+    else if (!compare_slow(I,c)) return;
+    switch (OP) {
+      case EQ: fail = (c != 0); break;
+      case NE: fail = (c == 0); break;
+      case LT: fail = (c >= 0); break;
+      case GT: fail = (c <= 0); break;
+      case LE: fail = (c > 0); break;
+      case GE: fail = (c < 0); break;
+    }
+  }
+};
+struct compare_eq : comparison<EQ> {};
+struct compare_ne : comparison<NE> {};
+struct compare_lt : comparison<LT> {};
+struct compare_gt : comparison<GT> {};
+struct compare_le : comparison<LE> {};
+struct compare_ge : comparison<GE> {};
+
+// =============================================================================
+// indexing instructions (built by link())
+// =============================================================================
+
+struct switch_on_term {
+  static void run(const instr& I) {
+    const procedure& proc = PROC[I.k];
+    switch (tag_of(STORE[deref(X0)])) {
+      case REF: P = proc.Lv; break;
+      case STR: P = proc.Ls; break;
+      case LIS: P = proc.Ll; break;
+      default:  P = proc.Lc;
+    }
+    if (P < 0) fail = true;
+  }
+};
+
+struct switch_on_constant {
+  static void run(const instr& I) {
+    P = SWITCH[I.k][STORE[deref(X0)]];
+    if (P < 0) fail = true;
+  }
+};
+
+struct switch_on_structure {
+  static void run(const instr& I) {
+    P = SWITCH[I.k][STORE[val_of(STORE[deref(X0)])]];
+    if (P < 0) fail = true;
+  }
+};
 
 // =============================================================================
 // custom instructions
 // =============================================================================
 
-struct print_variable : instruction {
-  reg i;
-  string var;
-  print_variable(istream& in) {
-    i = read_register(in);
+template<class R> struct print_variable {
+  template<class In> static void assemble(In& in, instr& I) {
+    read_register(in,I.i,I.ci);
+    string var;
     in >> var;
+    I.k = atom(var);
   }
-  void run() const {
-    query_vars.emplace_back(var,i);
-    int a = deref(X.addr(i));
+  static void run(const instr& I) {
+    const string& var = ATOM[I.k];
+    query_vars.emplace_back(var,R::addr(I.i));
+    int a = deref(R::addr(I.i));
     if (STORE[a] == data(REF,a) && !query_unbound_vars.count(a)) {
       query_unbound_vars[a] = var;
     }
     P = P+1;
   }
 };
+VARIANTS1(print_variable)
 
-struct flush_variables : instruction {
-  flush_variables(istream& in) {}
-  void run() const {
+struct flush_variables {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
     printf("\n");
     if (query_vars.size() == 0) printf("true.\n");
     else for (const auto& var : query_vars) {
       printf("%s = ",var.first.c_str());
-      int a = deref(X.addr(var.second));
+      int a = deref(var.second);
       if (STORE[a] != data(REF,a)) dfs(a);
       else {
         const auto& s = query_unbound_vars[a];
@@ -608,20 +1568,39 @@ struct flush_variables : instruction {
     clear_query();
     P = P+1;
   }
-  void dfs(int a) const {
-    const auto& c = STORE[a = deref(a)].d;
-    if (c.first == REF) {
+  static void dfs(int a) {
+    cell c = STORE[a = deref(a)];
+    if (tag_of(c) == REF) {
       if (!query_unbound_vars.count(a)) printf("<unbound>");
       else printf("%s",query_unbound_vars[a].c_str());
     }
+    else if (tag_of(c) == CON) printf("%s",ATOM[val_of(c)].c_str());
+    else if (tag_of(c) == LIS) {
+      printf("[");
+      dfs(val_of(c));
+      int t = deref(val_of(c)+1);
+      for (; tag_of(STORE[t]) == LIS; t = deref(val_of(STORE[t])+1)) {
+        printf(",");
+        dfs(val_of(STORE[t]));
+      }
+      if (STORE[t] != NIL) {
+        printf("|");
+        dfs(t);
+      }
+      printf("]");
+    }
+    else if (tag_of(c) == INT || tag_of(c) == NUM) {
+      printf("%s",number_text(c).c_str());
+    }
     else {
-      const auto& f = STORE[c.second].f;
-      printf("%s",f.first.c_str());
-      if (f.second) {
+      int v = val_of(c);
+      const functor& f = FUNCTOR[val_of(STORE[v])];
+      printf("%s",ATOM[f.name].c_str());
+      if (f.arity) {
         printf("(");
-        for (int i = 1; i <= f.second; i++) {
+        for (int i = 1; i <= f.arity; i++) {
           if (i > 1) printf(",");
-          dfs(c.second+i);
+          dfs(v+i);
         }
         printf(")");
       }
@@ -629,9 +1608,9 @@ struct flush_variables : instruction {
   }
 };
 
-struct wait_user : instruction {
-  wait_user(istream&) {}
-  void run() const {
+struct wait_user {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
     if (B == -1) halt = true; // no more choices
     else {
       printf("Backtrack? (y/n) ");
@@ -646,90 +1625,1005 @@ struct wait_user : instruction {
   }
 };
 
+// end of code. every slot past CODE_SIZE holds one of these
+struct no_instruction {
+  template<class In> static void assemble(In&, instr&) {}
+  static void run(const instr&) {
+    fatal(EMPTY_INSTRUCTION,"at %d",P);
+  }
+};
+
+// =============================================================================
+// super-instructions
+// =============================================================================
+
+// hot sequences found by profiling run under a single dispatch. the
+// assembler rewrites the first instruction of a sequence and leaves the
+// others in place: each part reads its own operands and advances P, so
+// labels and return addresses stay where they were
+template<class... T> struct fused;
+template<class A> struct fused<A> {
+  static void run(const instr& I) { A::run(I); }
+};
+template<class A, class... T> struct fused<A,T...> {
+  static void run(const instr& I) {
+    A::run(I);
+    if (!fail) fused<T...>::run(CODE[P]);
+  }
+};
+
+typedef fused<get_structure_x,unify_variable_x,unify_variable_x>
+  get_structure_unify_variables;
+typedef fused<get_list_x,unify_variable_x,unify_variable_x>
+  get_list_unify_variables;
+typedef fused<get_list_x,unify_value_x,unify_variable_x>
+  get_list_unify_value_variable;
+typedef fused<get_constant_x,get_structure_x> get_constant_structure;
+typedef fused<unify_constant,unify_constant,proceed> unify_constants_proceed;
+typedef fused<unify_constant,unify_constant> unify_constants;
+typedef fused<unify_constant,proceed> unify_constant_proceed;
+typedef fused<get_constant_x,proceed> get_constant_proceed;
+typedef fused<put_value_xx,put_value_xx,execute> put_values_execute;
+typedef fused<put_value_xx,put_value_xx> put_values;
+typedef fused<put_value_xx,call> put_value_call;
+typedef fused<put_value_xx,execute> put_value_execute;
+typedef fused<deallocate,execute> deallocate_execute;
+typedef fused<allocate,get_variable_yx> allocate_get_variable;
+
+// =============================================================================
+// dispatch
+// =============================================================================
+
+#define INSTRUCTIONS(X) \
+  X(no_instruction) \
+  X(put_structure_x) \
+  X(put_structure_y) \
+  X(set_variable_x) \
+  X(set_variable_y) \
+  X(set_value_x) \
+  X(set_value_y) \
+  X(set_void) \
+  X(set_local_value_x) \
+  X(set_local_value_y) \
+  X(get_structure_x) \
+  X(get_structure_y) \
+  X(unify_variable_x) \
+  X(unify_variable_y) \
+  X(unify_value_x) \
+  X(unify_value_y) \
+  X(unify_local_value_x) \
+  X(unify_local_value_y) \
+  X(unify_void) \
+  X(call) \
+  X(execute) \
+  X(proceed) \
+  X(put_variable_xx) \
+  X(put_variable_xy) \
+  X(put_variable_yx) \
+  X(put_variable_yy) \
+  X(put_value_xx) \
+  X(put_value_xy) \
+  X(put_value_yx) \
+  X(put_value_yy) \
+  X(put_unsafe_value_xx) \
+  X(put_unsafe_value_xy) \
+  X(put_unsafe_value_yx) \
+  X(put_unsafe_value_yy) \
+  X(get_variable_xx) \
+  X(get_variable_xy) \
+  X(get_variable_yx) \
+  X(get_variable_yy) \
+  X(get_value_xx) \
+  X(get_value_xy) \
+  X(get_value_yx) \
+  X(get_value_yy) \
+  X(allocate) \
+  X(deallocate) \
+  X(try_clause) \
+  X(retry_clause) \
+  X(trust_clause) \
+  X(neck_cut) \
+  X(get_level_x) \
+  X(get_level_y) \
+  X(cut_x) \
+  X(cut_y) \
+  X(put_constant_x) \
+  X(put_constant_y) \
+  X(get_constant_x) \
+  X(get_constant_y) \
+  X(set_constant) \
+  X(unify_constant) \
+  X(put_list_x) \
+  X(put_list_y) \
+  X(get_list_x) \
+  X(get_list_y) \
+  X(put_nil_x) \
+  X(put_nil_y) \
+  X(get_nil_x) \
+  X(get_nil_y) \
+  X(set_nil) \
+  X(unify_nil) \
+  X(evaluate) \
+  X(add) \
+  X(subtract) \
+  X(multiply) \
+  X(divide) \
+  X(compare_eq) \
+  X(compare_ne) \
+  X(compare_lt) \
+  X(compare_gt) \
+  X(compare_le) \
+  X(compare_ge) \
+  X(switch_on_term) \
+  X(switch_on_constant) \
+  X(switch_on_structure) \
+  X(print_variable_x) \
+  X(print_variable_y) \
+  X(flush_variables) \
+  X(wait_user) \
+  X(get_structure_unify_variables) \
+  X(get_list_unify_variables) \
+  X(get_list_unify_value_variable) \
+  X(get_constant_structure) \
+  X(unify_constants_proceed) \
+  X(unify_constants) \
+  X(unify_constant_proceed) \
+  X(get_constant_proceed) \
+  X(put_values_execute) \
+  X(put_values) \
+  X(put_value_call) \
+  X(put_value_execute) \
+  X(deallocate_execute) \
+  X(allocate_get_variable)
+
+#define OPCODE(X) OP_##X,
+enum opcode { INSTRUCTIONS(OPCODE) OP_COUNT };
+#undef OPCODE
+
+// handler address of each opcode, exported by run_code(true)
+static const void* const* HANDLER;
+
+// runs CODE from P until halt or a failure with no choice point left.
+// the default build threads the code: each instruction jumps straight to the
+// handler of the next one (computed goto). -DWAM_SWITCH gives a switch loop
+static void run_code(bool init = false) {
+#ifdef WAM_SWITCH
+  if (init) return;
+#define CASE(X) case OP_##X: X::run(CODE[P]); break;
+  for (;;) {
+    switch (CODE[P].op) { INSTRUCTIONS(CASE) }
+    if (halt) return;
+    if (fail) {
+      if (B == -1) return;
+      fail = false;
+      backtrack();
+    }
+  }
+#undef CASE
+#else
+#define ADDRESS(X) &&L_##X,
+  static const void* const handler[] = { INSTRUCTIONS(ADDRESS) };
+#undef ADDRESS
+  if (init) { HANDLER = handler; return; }
+#define NEXT() if (halt || fail) goto stop; goto *CODE[P].h
+#define HANDLE(X) L_##X: X::run(CODE[P]); NEXT();
+  NEXT();
+  INSTRUCTIONS(HANDLE)
+stop:
+  if (halt || B == -1) return;
+  fail = false;
+  backtrack();
+  NEXT();
+#undef HANDLE
+#undef NEXT
+#endif
+}
+
+static void emit(instr& I, int op) {
+  I.op = op;
+#ifndef WAM_SWITCH
+  if (!HANDLER) run_code(true);
+  I.h = HANDLER[op];
+#endif
+}
+
 // =============================================================================
 // assembler
 // =============================================================================
 
-#define ASSEMBLER(X) {#X,[](istream& in) { return new X(in); }}
-static map<string,function<instruction*(istream&)>> assembler{
-  ASSEMBLER(put_structure),
-  ASSEMBLER(set_variable),
-  ASSEMBLER(set_value),
-  ASSEMBLER(get_structure),
-  ASSEMBLER(unify_variable),
-  ASSEMBLER(unify_value),
+// each instruction assembles from text (In = istream) or from the lines
+// of the compiler (In = line_reader)
+template<int OP, class X, class In> static void assemble0(In& in, instr& I) {
+  emit(I,OP);
+  X::assemble(in,I);
+}
+// variants follow the classes of the operands, x before y
+template<int OP, class X, class In> static void assemble1(In& in, instr& I) {
+  X::assemble(in,I);
+  emit(I,OP+(I.ci == 'Y'));
+}
+template<int OP, class X, class In> static void assemble2(In& in, instr& I) {
+  X::assemble(in,I);
+  emit(I,OP+2*(I.ci == 'Y')+(I.cj == 'Y'));
+}
+struct assembler_t {
+  void (*text)(istream&, instr&);
+  void (*line)(line_reader&, instr&);
+};
+#define ASSEMBLER(X) {#X,{\
+  assemble0<OP_##X,X,istream>,assemble0<OP_##X,X,line_reader>\
+}}
+#define ASSEMBLER1(X) {#X,{\
+  assemble1<OP_##X##_x,X##_x,istream>,assemble1<OP_##X##_x,X##_x,line_reader>\
+}}
+#define ASSEMBLER2(X) {#X,{\
+  assemble2<OP_##X##_xx,X##_xx,istream>,\
+  assemble2<OP_##X##_xx,X##_xx,line_reader>\
+}}
+static map<string,assembler_t> assembler{
+  ASSEMBLER1(put_structure),
+  ASSEMBLER1(set_variable),
+  ASSEMBLER1(set_value),
+  ASSEMBLER(set_void),
+  ASSEMBLER1(set_local_value),
+  ASSEMBLER1(get_structure),
+  ASSEMBLER1(unify_variable),
+  ASSEMBLER1(unify_value),
+  ASSEMBLER1(unify_local_value),
+  ASSEMBLER(unify_void),
   ASSEMBLER(call),
+  ASSEMBLER(execute),
   ASSEMBLER(proceed),
-  ASSEMBLER(put_variable),
-  ASSEMBLER(put_value),
-  ASSEMBLER(get_variable),
-  ASSEMBLER(get_value),
+  ASSEMBLER2(put_variable),
+  ASSEMBLER2(put_value),
+  ASSEMBLER2(put_unsafe_value),
+  ASSEMBLER2(get_variable),
+  ASSEMBLER2(get_value),
   ASSEMBLER(allocate),
   ASSEMBLER(deallocate),
-  ASSEMBLER(try_me_else),
-  ASSEMBLER(retry_me_else),
-  ASSEMBLER(trust_me),
-  ASSEMBLER(print_variable),
+  ASSEMBLER(neck_cut),
+  ASSEMBLER1(get_level),
+  ASSEMBLER1(cut),
+  ASSEMBLER1(put_constant),
+  ASSEMBLER1(get_constant),
+  ASSEMBLER(set_constant),
+  ASSEMBLER(unify_constant),
+  ASSEMBLER1(put_list),
+  ASSEMBLER1(get_list),
+  ASSEMBLER1(put_nil),
+  ASSEMBLER1(get_nil),
+  ASSEMBLER(set_nil),
+  ASSEMBLER(unify_nil),
+  ASSEMBLER(evaluate),
+  ASSEMBLER(add),
+  ASSEMBLER(subtract),
+  ASSEMBLER(multiply),
+  ASSEMBLER(divide),
+  ASSEMBLER(compare_eq),
+  ASSEMBLER(compare_ne),
+  ASSEMBLER(compare_lt),
+  ASSEMBLER(compare_gt),
+  ASSEMBLER(compare_le),
+  ASSEMBLER(compare_ge),
+  ASSEMBLER1(print_variable),
   ASSEMBLER(flush_variables),
   ASSEMBLER(wait_user)
 };
 #undef ASSEMBLER
+#undef ASSEMBLER1
+#undef ASSEMBLER2
+// the same, by wam_op
+static const vector<void (*)(line_reader&, instr&)> LINE_ASSEMBLER = []() {
+  vector<void (*)(line_reader&, instr&)> v;
+  for (int op = 0; op < WAM_COUNT; op++) {
+    v.push_back(assembler.at(wam_name[op]).line);
+  }
+  return v;
+}();
+
+// opcode of each super-instruction, then the sequence it runs. a transfer
+// of control only ends a sequence, so none runs past the end of a clause
+static const vector<vector<int>> SUPER{
+  {OP_get_structure_unify_variables,
+    OP_get_structure_x,OP_unify_variable_x,OP_unify_variable_x},
+  {OP_get_list_unify_variables,
+    OP_get_list_x,OP_unify_variable_x,OP_unify_variable_x},
+  {OP_get_list_unify_value_variable,
+    OP_get_list_x,OP_unify_value_x,OP_unify_variable_x},
+  {OP_unify_constants_proceed,
+    OP_unify_constant,OP_unify_constant,OP_proceed},
+  {OP_get_constant_structure,OP_get_constant_x,OP_get_structure_x},
+  {OP_unify_constants,OP_unify_constant,OP_unify_constant},
+  {OP_unify_constant_proceed,OP_unify_constant,OP_proceed},
+  {OP_get_constant_proceed,OP_get_constant_x,OP_proceed},
+  {OP_put_values_execute,OP_put_value_xx,OP_put_value_xx,OP_execute},
+  {OP_put_values,OP_put_value_xx,OP_put_value_xx},
+  {OP_put_value_call,OP_put_value_xx,OP_call},
+  {OP_put_value_execute,OP_put_value_xx,OP_execute},
+  {OP_deallocate_execute,OP_deallocate,OP_execute},
+  {OP_allocate_get_variable,OP_allocate,OP_get_variable_yx}
+};
+static void fuse(int beg) {
+  for (int i = beg; i < CODE_SIZE;) {
+    int n = 1, op = -1; // the longest sequence at i
+    for (auto& s : SUPER) {
+      int j = 1;
+      while (j < s.size() && i+j-1 < CODE_SIZE && CODE[i+j-1].op == s[j]) j++;
+      if (j == s.size() && j-1 > n) n = j-1, op = s[0];
+    }
+    if (op != -1) emit(CODE[i],op);
+    i += n;
+  }
+}
+
+// =============================================================================
+// linker
+// =============================================================================
+
+static instr& link_emit(int op) {
+  if (LINK_SIZE == MAXC) fatal(CODE_OVERFLOW,"in the link area");
+  instr& I = CODE[LINK_SIZE++];
+  emit(I,op);
+  return I;
+}
+
+// entry point of a list of alternative clauses of a procedure of arity n
+static int link_alternatives(const vector<int>& alt, int n) {
+  if (alt.empty()) return -1;
+  if (alt.size() == 1) return alt[0];
+  int L = LINK_SIZE;
+  for (int i = 0; i < alt.size(); i++) {
+    int op = OP_retry_clause;
+    if (i == 0) op = OP_try_clause;
+    else if (i == alt.size()-1) op = OP_trust_clause;
+    instr& I = link_emit(op);
+    I.k = alt[i];
+    I.n = n;
+  }
+  return L;
+}
+
+// entry point of a switch on the first argument. t gets the table
+static int link_switch(int op, switch_table& table, int& t) {
+  if (table.small.empty()) return table.miss;
+  if (FREE_SWITCH.empty()) t = SWITCH.size(), SWITCH.emplace_back();
+  else t = FREE_SWITCH.back(), FREE_SWITCH.pop_back();
+  swap(SWITCH[t],table);
+  int L = LINK_SIZE;
+  link_emit(op).k = t;
+  return L;
+}
+
+static void link_procedure(int f, const vector<int>& alt) {
+  procedure& proc = PROC[f];
+  int n = FUNCTOR[f].arity;
+  proc.entry = proc.Lv = link_alternatives(alt,n);
+  if (n == 0 || alt.size() < 2) return;
+  // clauses by first argument key. variable ones go in every bucket
+  map<cell,vector<int>> bucket;
+  vector<int> var;
+  for (int P : alt) {
+    auto it = KEY.find(P);
+    if (it == KEY.end()) var.push_back(P);
+    else bucket[it->second].push_back(P);
+  }
+  if (bucket.empty()) return;
+  switch_table cons, strs;
+  proc.Ll = cons.miss = strs.miss = link_alternatives(var,n);
+  for (auto& kv : bucket) {
+    vector<int> tmp;
+    merge(kv.second.begin(),kv.second.end(),var.begin(),var.end(),
+      back_inserter(tmp));
+    int L = link_alternatives(tmp,n);
+    switch (tag_of(kv.first)) {
+      case FCT: strs.insert(kv.first,L); break;
+      case LIS: proc.Ll = L; break;
+      default:  cons.insert(kv.first,L);
+    }
+  }
+  proc.Lc = link_switch(OP_switch_on_constant,cons,proc.Sc);
+  proc.Ls = link_switch(OP_switch_on_structure,strs,proc.Ss);
+  proc.entry = LINK_SIZE;
+  link_emit(OP_switch_on_term).k = f;
+}
+
+// resolves call sites and builds the entry points of the procedures whose
+// clauses changed. their old link code is left behind, and everything is
+// relinked from scratch once there is more of it than of live code
+static void link(int beg) {
+  clock_t start = clock();
+  if (2*LINK_GARBAGE > LINK_SIZE-LINK0) {
+    while (LINK0 < LINK_SIZE) CODE[--LINK_SIZE] = instr();
+    SWITCH.clear();
+    FREE_SWITCH.clear();
+    PROC.assign(FUNCTOR.size(),procedure());
+    LINK_GARBAGE = 0;
+    for (auto& kv : symbol_table) touch(kv.first);
+  }
+  int linked = STALE.size();
+  for (auto& lab : STALE) {
+    vector<int> alt;
+    auto it = symbol_table.find(lab);
+    if (it != symbol_table.end()) for (auto& cl : it->second) {
+      if (cl.on) alt.push_back(cl.P);
+    }
+    int f = lab2func(lab), L = LINK_SIZE;
+    PROC.resize(FUNCTOR.size());
+    procedure& old = PROC[f];
+    LINK_GARBAGE += old.size;
+    for (int t : {old.Sc,old.Ss}) if (t != -1) {
+      SWITCH[t] = switch_table();
+      FREE_SWITCH.push_back(t);
+    }
+    PROC[f] = procedure();
+    link_procedure(f,alt);
+    PROC[f].size = LINK_SIZE-L;
+  }
+  STALE.clear();
+  PROC.resize(FUNCTOR.size());
+  if (LINK_VERBOSE) fprintf(
+    stderr,
+    "link: %d procedure(s), %d instructions live, %d garbage, %.3f ms\n",
+    linked,
+    LINK_SIZE-LINK0-LINK_GARBAGE,
+    LINK_GARBAGE,
+    double(clock()-start)/CLOCKS_PER_SEC*1000
+  );
+  // report calls of the new code that can't succeed
+  set<int> undefined;
+  for (int p = beg; p < CODE_SIZE; p++) {
+    int op = CODE[p].op;
+    if ((op == OP_call || op == OP_execute) && PROC[CODE[p].k].entry < 0) {
+      undefined.insert(CODE[p].k);
+    }
+  }
+  for (int f : undefined) fprintf(
+    stderr,
+    "warning (UNDEFINED_PROCEDURE): %s\n",
+    FUNCTOR[f].label.c_str()
+  );
+}
 
 // =============================================================================
 // API
 // =============================================================================
 
+// guard faults while the query runs abort it. other faults crash as usual
+static sigjmp_buf RESOURCE_ERROR;
+static bool running;
+static void guard_fault(int, siginfo_t* si, void*) {
+  char* a = (char*)si->si_addr;
+  for (int i = 0; running && i < GUARDS_SIZE; i++) {
+    if (GUARDS[i].beg <= a && a < GUARDS[i].beg+GUARD) {
+      siglongjmp(RESOURCE_ERROR,i+1);
+    }
+  }
+  signal(SIGSEGV,SIG_DFL);
+}
+
+// first argument key of a clause: a functor, a constant or [|] for lists.
+// boxed numbers are not keys, their clauses go in every bucket
+static cell key(const string& s) {
+  if (s == "[|]") return data(LIS,0);
+  size_t i = s.rfind('/');
+  if (i != string::npos && i+1 < s.size()) {
+    if (s.find_first_not_of("0123456789",i+1) == string::npos) {
+      return data(FCT,lab2func(s));
+    }
+  }
+  instr I;
+  text_constant(s,I);
+  return constant(I);
+}
+static cell read_key(istream& in) {
+  return key(read_text(in));
+}
+
 map<string,vector<clause>> symbol_table;
 
-string machine_read_functor(istream& in) { return read_functor(in); }
+string machine_read_functor(istream& in) {
+  return FUNCTOR[read_functor(in)].label;
+}
 
-string machine_functor_name(const string& f) { return lab2func(f).first; }
+string machine_functor_name(const string& f) {
+  return ATOM[FUNCTOR[lab2func(f)].name];
+}
 
 void machine_close() { free_code(); }
 
-static void push_label(const string& label, istream& in) {
-  in.get();
-  symbol_table[label].push_back({
-    true,
-    CODE_SIZE,
-    string(istreambuf_iterator<char>(in),{})
-  });
+void machine_memory(int64_t heap, int64_t stack, int64_t trail) {
+  heap = max<int64_t>(heap/sizeof(cell),1);
+  stack = max<int64_t>(stack/sizeof(cell),1);
+  trail = max<int64_t>(trail/sizeof(int),1);
+  heap = page_round(heap*sizeof(cell))/sizeof(cell);
+  if (H0+heap+GUARD+stack > INT_MAX) {
+    fatal(OUT_OF_MEMORY,"heap and stack too big");
+  }
+  HN = H0+heap;
+  YA0 = HN+GUARD/sizeof(cell);
+  YAN = YA0+stack;
+  STORE = reserve<cell>(YAN,"environment stack");
+  protect(&STORE[HN],"heap");
+  CHOICE_STACK = reserve<cell>(stack,"choice point stack");
+  TRAIL = reserve<int>(trail,"trail");
+  PDL = reserve<int>(2*(heap+stack),"unification stack");
+  struct sigaction sa = {};
+  sa.sa_sigaction = guard_fault;
+  sa.sa_flags = SA_SIGINFO;
+  sigaction(SIGSEGV,&sa,nullptr);
 }
-void machine_run(FILE* fp) {
-  // assemble
-  for (string s; getline(fp,s);) {
-    stringstream ss(s);
-    if (s[0] == '\'') { // string label
-      string label = read_functor(ss);
-      push_label(label,ss);
+
+void machine_gc(int watermark, bool verbose) {
+  GC.percent = max(min(watermark,100),0);
+  GC.verbose = verbose;
+}
+
+void machine_link(bool verbose) {
+  LINK_VERBOSE = verbose;
+}
+void machine_relink(const string& label) {
+  touch(label);
+}
+
+void machine_gc_statistics() {
+  printf("%d collection(s), %lld cell(s) reclaimed, %.3f ms\n",
+    GC.collections,GC.reclaimed,GC.seconds*1000);
+}
+
+// =============================================================================
+// object files
+// =============================================================================
+
+// binary .wam: the code as the machine holds it, so loading is a copy and a
+// relocation pass. symbols are numbered locally in the file and mapped to
+// this machine's ids on load. all fields are int32 in host order:
+//   header    magic, version, instruction set hash, counts (OBJECT_COUNTS)
+//   code      instr records, with h = 0
+//   relocs    (offset, kind): CODE[offset].k is an atom, functor or literal
+//   keys      (offset, tag, value): index keys, CON and FCT values are local
+//   labels    (offset, label string, source string)
+//   atoms     strings
+//   functors  (atom, arity)
+//   literals  strings, the text of each literal pool constant
+// strings are a length and the bytes, padded to 4
+#define OBJECT_MAGIC   0x4f4d4157 // "WAMO"
+#define OBJECT_VERSION 1
+enum object_count { CODE_N, RELOC_N, KEY_N, LABEL_N, ATOM_N, FUNCTOR_N,
+  LITERAL_N, OBJECT_COUNTS };
+enum reloc_kind { RELOC_ATOM, RELOC_FUNCTOR, RELOC_LITERAL };
+
+// objects are only loaded by the machine that wrote them: same opcodes and
+// same instr layout
+static uint32_t instruction_set() {
+#define NAME(X) #X " "
+  static const char names[] = INSTRUCTIONS(NAME);
+#undef NAME
+  uint32_t h = 2166136261u ^ sizeof(instr); // FNV-1a
+  for (char c : names) h = (h^uint8_t(c))*16777619u;
+  return h;
+}
+
+// kind of symbol in the k operand of an instruction, or -1
+static int reloc(const instr& I) {
+  switch (I.op) {
+    case OP_put_structure_x: case OP_put_structure_y:
+    case OP_get_structure_x: case OP_get_structure_y:
+    case OP_call: case OP_execute:
+      return RELOC_FUNCTOR;
+    case OP_print_variable_x: case OP_print_variable_y:
+      return RELOC_ATOM;
+    case OP_put_constant_x: case OP_put_constant_y:
+    case OP_get_constant_x: case OP_get_constant_y:
+    case OP_set_constant: case OP_unify_constant:
+      if (I.n == CON) return RELOC_ATOM;
+      if (I.n == NAT) return RELOC_LITERAL;
+  }
+  return -1;
+}
+
+// classes of the i, j and n operands of each instruction the assembler
+// emits, to check objects. X is an X register and Y a permanent variable of
+// the current environment. V is any of the two or an immediate, as ci or cj
+// says. C is a count, L the variables live after a call and A the size of
+// a new environment. T is the tag of a constant. - is unused
+static const char* operand_classes(int op) {
+  switch (op) {
+    case OP_put_structure_x: case OP_set_variable_x: case OP_set_value_x:
+    case OP_set_local_value_x: case OP_get_structure_x:
+    case OP_unify_variable_x: case OP_unify_value_x:
+    case OP_unify_local_value_x: case OP_get_level_x: case OP_cut_x:
+    case OP_put_list_x: case OP_get_list_x: case OP_put_nil_x:
+    case OP_get_nil_x: case OP_print_variable_x:
+      return "X--";
+    case OP_put_structure_y: case OP_set_variable_y: case OP_set_value_y:
+    case OP_set_local_value_y: case OP_get_structure_y:
+    case OP_unify_variable_y: case OP_unify_value_y:
+    case OP_unify_local_value_y: case OP_get_level_y: case OP_cut_y:
+    case OP_put_list_y: case OP_get_list_y: case OP_put_nil_y:
+    case OP_get_nil_y: case OP_print_variable_y:
+      return "Y--";
+    case OP_put_variable_xx: case OP_put_value_xx:
+    case OP_put_unsafe_value_xx: case OP_get_variable_xx:
+    case OP_get_value_xx:
+      return "XX-";
+    case OP_put_variable_xy: case OP_put_value_xy:
+    case OP_put_unsafe_value_xy: case OP_get_variable_xy:
+    case OP_get_value_xy:
+      return "XY-";
+    case OP_put_variable_yx: case OP_put_value_yx:
+    case OP_put_unsafe_value_yx: case OP_get_variable_yx:
+    case OP_get_value_yx:
+      return "YX-";
+    case OP_put_variable_yy: case OP_put_value_yy:
+    case OP_put_unsafe_value_yy: case OP_get_variable_yy:
+    case OP_get_value_yy:
+      return "YY-";
+    case OP_put_constant_x: case OP_get_constant_x:
+      return "X-T";
+    case OP_put_constant_y: case OP_get_constant_y:
+      return "Y-T";
+    case OP_set_constant: case OP_unify_constant:
+      return "--T";
+    case OP_set_void: case OP_unify_void:
+      return "--C";
+    case OP_call:
+      return "--L";
+    case OP_allocate:
+      return "--A";
+    case OP_evaluate:
+      return "V-X";
+    case OP_add: case OP_subtract: case OP_multiply: case OP_divide:
+      return "VVX";
+    case OP_compare_eq: case OP_compare_ne: case OP_compare_lt:
+    case OP_compare_gt: case OP_compare_le: case OP_compare_ge:
+      return "VV-";
+    case OP_execute: case OP_proceed: case OP_deallocate: case OP_neck_cut:
+    case OP_set_nil: case OP_unify_nil: case OP_flush_variables:
+    case OP_wait_user:
+      return "---";
+  }
+  return nullptr; // made by fuse() or link(), never written
+}
+
+struct object_writer {
+  vector<int32_t> out;
+  unordered_map<int,int> local[3]; // machine id -> local id, by reloc kind
+  vector<int> ids[3];              // local id -> machine id
+  void put(int32_t x) { out.push_back(x); }
+  void put(const string& s) {
+    put(s.size());
+    size_t i = out.size();
+    out.resize(i+(s.size()+3)/4);
+    memcpy(&out[i],s.data(),s.size());
+  }
+  int id(int kind, int x) {
+    auto it = local[kind].find(x);
+    if (it != local[kind].end()) return it->second;
+    ids[kind].push_back(x);
+    return local[kind][x] = ids[kind].size()-1;
+  }
+};
+
+void machine_write_object(FILE* fp) {
+  object_writer w;
+  vector<int32_t> relocs, keys, counts(OBJECT_COUNTS);
+  vector<instr> code(CODE+UNLINKED,CODE+CODE_SIZE);
+  for (int i = 0; i < code.size(); i++) {
+    instr& I = code[i];
+    I.h = nullptr;
+    int kind = reloc(I);
+    if (kind == -1) continue;
+    I.k = w.id(kind,I.k);
+    relocs.push_back(i);
+    relocs.push_back(kind);
+  }
+  for (auto it = KEY.lower_bound(UNLINKED); it != KEY.end(); it++) {
+    tag t = tag_of(it->second);
+    int v = val_of(it->second);
+    if (t == CON) v = w.id(RELOC_ATOM,v);
+    if (t == FCT) v = w.id(RELOC_FUNCTOR,v);
+    keys.insert(keys.end(),{it->first-UNLINKED,t,v});
+  }
+  // labels in code order, which is clause order
+  vector<pair<int,pair<string,string>>> labels;
+  for (auto& kv : symbol_table) for (auto& cl : kv.second) {
+    if (cl.P >= UNLINKED) labels.push_back({cl.P,{kv.first,cl.src}});
+  }
+  sort(labels.begin(),labels.end());
+  // functor names go in the atom table
+  for (int f : w.ids[RELOC_FUNCTOR]) w.id(RELOC_ATOM,FUNCTOR[f].name);
+  counts[CODE_N] = code.size();
+  counts[RELOC_N] = relocs.size()/2;
+  counts[KEY_N] = keys.size()/3;
+  counts[LABEL_N] = labels.size();
+  counts[ATOM_N] = w.ids[RELOC_ATOM].size();
+  counts[FUNCTOR_N] = w.ids[RELOC_FUNCTOR].size();
+  counts[LITERAL_N] = w.ids[RELOC_LITERAL].size();
+  w.put(OBJECT_MAGIC);
+  w.put(OBJECT_VERSION);
+  w.put(instruction_set());
+  for (int c : counts) w.put(c);
+  // the header is 40 bytes, so the code is 8-byte aligned
+  size_t i = w.out.size();
+  w.out.resize(i+code.size()*sizeof(instr)/4);
+  memcpy(&w.out[i],code.data(),code.size()*sizeof(instr));
+  w.out.insert(w.out.end(),relocs.begin(),relocs.end());
+  w.out.insert(w.out.end(),keys.begin(),keys.end());
+  for (auto& l : labels) {
+    w.put(l.first-UNLINKED);
+    w.put(l.second.first);
+    w.put(l.second.second);
+  }
+  for (int a : w.ids[RELOC_ATOM]) w.put(ATOM[a]);
+  for (int f : w.ids[RELOC_FUNCTOR]) {
+    w.put(w.local[RELOC_ATOM][FUNCTOR[f].name]);
+    w.put(FUNCTOR[f].arity);
+  }
+  unordered_map<int,string> text; // literal address -> text
+  for (auto& kv : LITERAL) text[kv.second] = kv.first;
+  for (int l : w.ids[RELOC_LITERAL]) w.put(text[l]);
+  if (fp) fwrite(w.out.data(),sizeof(int32_t),w.out.size(),fp);
+  // the code was only assembled to be written
+  for (auto it = symbol_table.begin(); it != symbol_table.end();) {
+    auto& cls = it->second;
+    while (!cls.empty() && cls.back().P >= UNLINKED) cls.pop_back();
+    if (cls.empty()) it = symbol_table.erase(it);
+    else it++;
+  }
+  free_code(UNLINKED);
+}
+
+// reads an object in place. a read past the end clears ok
+struct object_reader {
+  const int32_t *p, *end;
+  bool ok;
+  const int32_t* take(int64_t n) {
+    if (n < 0 || end-p < n) ok = false;
+    if (!ok) return nullptr;
+    p += n;
+    return p-n;
+  }
+  int32_t get() { const int32_t* q = take(1); return q ? *q : 0; }
+  string str() {
+    int32_t n = get();
+    const int32_t* q = take(n < 0 ? -1 : (int64_t(n)+3)/4);
+    return q ? string((const char*)q,n) : string();
+  }
+};
+struct object_label { int P; string name, src; };
+// counts and environment sizes stay under the size of a guard, so that the
+// guards still catch the overflows they cause
+#define OBJECT_MAX int(GUARD/sizeof(cell))
+static bool in_range(int64_t x, int64_t lo, int64_t hi) {
+  return lo <= x && x < hi;
+}
+static bool valid_register(char c, int i, int env) {
+  if (c == 'X') return in_range(i,X0,LIT0);
+  return c == 'Y' && in_range(i,1,env+1);
+}
+// each operand of the code against its class. env is the size of the
+// environment of the clause, from its allocate to its deallocate. count is
+// the number of symbols of each reloc kind
+static bool valid_code(
+  const instr* code, int n, const vector<bool>& label,
+  const vector<int>& kind, const int32_t* count
+) {
+  int env = 0;
+  for (int i = 0; i < n; i++) {
+    const instr& I = code[i];
+    const char* cls = unsigned(I.op) < OP_COUNT ? operand_classes(I.op) : 0;
+    if (!cls) return false;
+    if (label[i]) env = 0;
+    int x[3] = {I.i,I.j,I.n};
+    char c[3] = {I.ci,I.cj,0};
+    for (int o = 0; o < 3; o++) switch (cls[o]) {
+      case 'X': case 'Y':
+        if (o < 2 && c[o] != cls[o]) return false;
+        if (!valid_register(cls[o],x[o],env)) return false;
+        break;
+      case 'V':
+        if (c[o] != '#' && !valid_register(c[o],x[o],env)) return false;
+        break;
+      case 'C':
+        if (!in_range(x[o],0,OBJECT_MAX)) return false;
+        break;
+      case 'L':
+        if (!in_range(x[o],0,env+1)) return false;
+        break;
+      case 'A':
+        if (!in_range(x[o],0,OBJECT_MAX)) return false;
+        env = x[o];
+        break;
+      case 'T':
+        if (x[o] != CON && x[o] != INT && x[o] != NAT) return false;
     }
-    else {
-      ss >> s;
-      if (s[s.size()-1] == ':') { // regular label
-        s.pop_back();
-        push_label(s,ss);
-      }
-      else if (assembler.count(s)) CODE[CODE_SIZE++] = assembler[s](ss);
-      else fprintf(stderr,"error (INVALID_INSTRUCTION): %s\n",s.c_str());
+    if (I.op == OP_deallocate) env = 0;
+    // exactly the symbols have a reloc, and it is of their kind
+    if (reloc(I) != kind[i]) return false;
+    if (kind[i] != -1 && !in_range(I.k,0,count[kind[i]])) return false;
+  }
+  return true;
+}
+static bool load_object(object_reader& r, const char* fn) {
+  int32_t n[OBJECT_COUNTS];
+  for (auto& c : n) c = r.get();
+  const instr* code = (const instr*)r.take(int64_t(n[CODE_N])*sizeof(instr)/4);
+  const int32_t* relocs = r.take(2*int64_t(n[RELOC_N]));
+  const int32_t* keys = r.take(3*int64_t(n[KEY_N]));
+  vector<object_label> labels;
+  for (int i = 0; r.ok && i < n[LABEL_N]; i++) {
+    int P = r.get();
+    string name = r.str();
+    labels.push_back({P,name,r.str()});
+  }
+  vector<string> atoms, literals;
+  vector<pair<int,int>> functors;
+  for (int i = 0; r.ok && i < n[ATOM_N]; i++) atoms.push_back(r.str());
+  for (int i = 0; r.ok && i < n[FUNCTOR_N]; i++) {
+    int name = r.get(), arity = r.get();
+    functors.push_back({name,arity});
+    // the arguments of a call go in X registers
+    r.ok = r.ok && in_range(name,0,atoms.size()) && in_range(arity,0,LIT0);
+  }
+  for (int i = 0; r.ok && i < n[LITERAL_N]; i++) literals.push_back(r.str());
+  // nothing goes in, not even a symbol, until the whole object checks out
+  vector<int> kind(r.ok ? n[CODE_N] : 0,-1); // reloc kind at each offset
+  vector<bool> label(kind.size());
+  for (int i = 0; r.ok && i < n[RELOC_N]; i++) {
+    int off = relocs[2*i], k = relocs[2*i+1];
+    r.ok = in_range(off,0,n[CODE_N]) && in_range(k,0,3) && kind[off] == -1;
+    if (r.ok) kind[off] = k;
+  }
+  for (int i = 0; r.ok && i < n[KEY_N]; i++) {
+    int off = keys[3*i], t = keys[3*i+1], v = keys[3*i+2];
+    r.ok = in_range(off,0,n[CODE_N]);
+    if (t == CON) r.ok = r.ok && in_range(v,0,n[ATOM_N]);
+    else if (t == FCT) r.ok = r.ok && in_range(v,0,n[FUNCTOR_N]);
+    else r.ok = r.ok && (t == INT || t == LIS);
+  }
+  for (auto& l : labels) {
+    r.ok = r.ok && in_range(l.P,0,n[CODE_N]);
+    if (r.ok) label[l.P] = true;
+  }
+  // the counts of atoms, functors and literals are in reloc_kind order
+  r.ok = r.ok && valid_code(code,n[CODE_N],label,kind,&n[ATOM_N]);
+  if (!r.ok) {
+    fprintf(stderr,"error (INVALID_OBJECT): %s is corrupt\n",fn);
+    return false;
+  }
+  vector<int> ids[3]; // local id -> machine id, by reloc kind
+  for (auto& a : atoms) ids[RELOC_ATOM].push_back(atom(a));
+  for (auto& f : functors) {
+    ids[RELOC_FUNCTOR].push_back(intern(ids[RELOC_ATOM][f.first],f.second));
+  }
+  for (auto& l : literals) ids[RELOC_LITERAL].push_back(literal(l));
+  int base = CODE_SIZE;
+  if (base+n[CODE_N] >= LINK0) fatal(CODE_OVERFLOW,"%s",fn);
+  memcpy(CODE+base,code,n[CODE_N]*sizeof(instr));
+  for (int i = 0; i < n[CODE_N]; i++) emit(CODE[base+i],CODE[base+i].op);
+  for (int i = 0; i < n[RELOC_N]; i++) {
+    int& k = CODE[base+relocs[2*i]].k;
+    k = ids[relocs[2*i+1]][k];
+  }
+  for (int i = 0; i < n[KEY_N]; i++) {
+    int t = keys[3*i+1], v = keys[3*i+2];
+    if (t == CON) v = ids[RELOC_ATOM][v];
+    if (t == FCT) v = ids[RELOC_FUNCTOR][v];
+    KEY[base+keys[3*i]] = data(tag(t),v);
+  }
+  for (auto& l : labels) {
+    symbol_table[l.name].push_back({true,base+l.P,l.src});
+    touch(l.name);
+  }
+  CODE_SIZE = base+n[CODE_N];
+  return true;
+}
+
+int machine_load_object(const char* fn) {
+  FILE* fp = fopen(fn,"r");
+  if (!fp) return 0;
+  fseek(fp,0,SEEK_END);
+  long size = ftell(fp);
+  void* m = MAP_FAILED;
+  if (size > 0) m = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fileno(fp),0);
+  fclose(fp);
+  if (m == MAP_FAILED) return 0;
+  object_reader r{(const int32_t*)m,(const int32_t*)m+size/4,true};
+  int st = 0;
+  if (r.get() == OBJECT_MAGIC) {
+    int version = r.get();
+    uint32_t isa = r.get();
+    st = -1;
+    if (version == OBJECT_VERSION && isa == instruction_set()) {
+      if (load_object(r,fn)) st = 1;
     }
+    else fprintf(
+      stderr,
+      "error (INVALID_OBJECT): %s was written by another version\n",
+      fn
+    );
   }
+  munmap(m,size);
+  return st;
+}
+
+static void push_label(const string& label, const string& src) {
+  touch(label);
+  symbol_table[label].push_back({true,CODE_SIZE,src});
+}
+static void push_label(const string& label, istream& in) {
+  in.get();
+  push_label(label,string(istreambuf_iterator<char>(in),{}));
+}
+void machine_assemble(const string& line) {
+  stringstream ss(line);
+  if (line[0] == '\'') { // string label
+    push_label(FUNCTOR[read_functor(ss)].label,ss);
+    return;
+  }
+  string s;
+  ss >> s;
+  if (s == "") return;
+  if (s[s.size()-1] == ':') { // regular label
+    s.pop_back();
+    push_label(s,ss);
+  }
+  else if (s == "index") {
+    cell key = read_key(ss);
+    if (tag_of(key) != NUM) KEY[CODE_SIZE] = key;
+  }
+  else if (assembler.count(s)) assembler[s].text(ss,CODE[CODE_SIZE++]);
+  else fprintf(stderr,"error (INVALID_INSTRUCTION): %s\n",s.c_str());
+}
+void machine_assemble(const code_line& L) {
+  if (L.op == CODE_LABEL) {
+    string label = L.text;
+    if (label[0] == '\'') label = FUNCTOR[functor_id(label)].label;
+    push_label(label,L.src ? L.src : "");
+  }
+  else if (L.op == CODE_INDEX) {
+    cell k = key(L.text);
+    if (tag_of(k) != NUM) KEY[CODE_SIZE] = k;
+  }
+  else if (0 <= L.op && L.op < WAM_COUNT) {
+    line_reader in = {L,0};
+    LINE_ASSEMBLER[L.op](in,CODE[CODE_SIZE++]);
+  }
+  else fprintf(stderr,"error (INVALID_INSTRUCTION): %d\n",L.op);
+}
+void machine_run() {
+  emit(CODE[CODE_SIZE],OP_no_instruction); // sentinel
+  fuse(UNLINKED);
+  link(UNLINKED);
   // run query
   if (symbol_table.count("query")) {
     P = symbol_table["query"][0].P;
     H = H0;
     HB = H0;
+    GC.limit = gc_watermark();
     E = -1;
     B = -1;
+    B0 = -1;
     TR = 0;
     halt = false;
     fail = false;
     clear_query();
-    while (!halt && !fail && CODE[P]) {
-      CODE[P]->run();
-      if (fail && B != -1) fail = false, backtrack();
+    int g = sigsetjmp(RESOURCE_ERROR,1);
+    if (!g) {
+      running = true;
+      run_code();
+      if (fail) printf("false.\n");
     }
-    if (!halt && !fail && !CODE[P]) fatal(EMPTY_INSTRUCTION,"at %d",P);
-    if (fail) printf("false.\n");
+    else {
+      const char* area = GUARDS[g-1].area;
+      fprintf(stderr,"error (RESOURCE_ERROR): %s overflow\n",area);
+    }
+    running = false;
     free_query();
   }
+  UNLINKED = CODE_SIZE;
+}
+void machine_run(FILE* fp) {
+  for (string s; getline(fp,s);) machine_assemble(s);
+  machine_run();
 }
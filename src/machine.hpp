@@ -1,10 +1,15 @@
 #ifndef MACHINE_HPP
 #define MACHINE_HPP
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
 
+extern "C" {
+#include "code.h"
+}
+
 struct clause {
   bool on;
   int P;
@@ -15,6 +20,16 @@ extern std::map<std::string,std::vector<clause>> symbol_table;
 std::string machine_read_functor(std::istream&);
 std::string machine_functor_name(const std::string&);
 void machine_close();
-void machine_run(FILE*);
+void machine_memory(int64_t heap, int64_t stack, int64_t trail); // bytes
+void machine_gc(int watermark, bool verbose); // watermark: % of the heap
+void machine_gc_statistics();
+void machine_link(bool verbose); // verbose: report each link to stderr
+void machine_relink(const std::string& label); // after toggling its clauses
+void machine_assemble(const std::string& line); // one line of WAM code
+void machine_assemble(const code_line&); // the same, from the compiler
+void machine_run(); // links the new code and runs its query, if any
+void machine_run(FILE*); // assembles the lines of the file, then runs
+void machine_write_object(FILE*); // the new code, as a binary .wam object
+int machine_load_object(const char*); // 1, 0 if not an object, -1 if bad
 
 #endif
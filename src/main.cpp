@@ -1,9 +1,12 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <map>
 #include <functional>
+#include <cstring>
 
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -30,7 +33,19 @@ static void welcome() {
 
 static void usage() {
   printf("\n");
-  printf("Usage: %s [COMMAND LINE OPTION]\n",a0);
+  printf("Usage: %s [OPTIONS] [COMMAND LINE OPTION]\n",a0);
+  printf("\n");
+  printf("Options (sizes in bytes, with an optional K, M or G):\n");
+  printf("  -H <size> (default 128M, or $PROLOG_HEAP)\n");
+  printf("     Heap size.\n");
+  printf("  -S <size> (default 32M, or $PROLOG_STACK)\n");
+  printf("     Size of the environment and of the choice point stacks.\n");
+  printf("  -T <size> (default 16M, or $PROLOG_TRAIL)\n");
+  printf("     Trail size.\n");
+  printf("     Memory is reserved, and only the pages in use take RAM.\n");
+  printf("     Overflows abort the query with a resource error.\n");
+  printf("  -j <count> (default the number of cores)\n");
+  printf("     Most files compiled at once by -c.\n");
   printf("\n");
   printf("Command line options:\n");
   printf("  -h\n");
@@ -38,11 +53,14 @@ static void usage() {
   printf("  -a <Prolog text between double quotes> (like -a \"?- p(X)\")\n");
   printf("     Compile one line of Prolog text from command line.\n");
   printf("  -c <file paths, wildcard * allowed> (like -c src/*.prolog)\n");
-  printf("     Compile Prolog text from a set of files to .wam files.\n");
+  printf("     Compile Prolog text from a set of files to .wam objects.\n");
+  printf("  -l <file paths>\n");
+  printf("     Print the Prolog assembly of a set of files.\n");
   printf("  -i <file paths>\n");
-  printf("     Interpret Prolog assembly from a set of files.\n");
+  printf("     Interpret .wam objects or Prolog assembly.\n");
   printf("  -r <file paths>\n");
   printf("     Compile and interpret Prolog text from a set of files.\n");
+  printf("     A .wam object newer than its source is loaded instead.\n");
   printf("  [file paths]\n");
   printf("     Start shell with an optional set of Prolog text files.\n");
   printf("\n");
@@ -53,8 +71,17 @@ static void usage() {
   printf("  more [list of <functor>[/<arity>]] - Display clauses with more.\n");
   printf("  less [list of <functor>[/<arity>]] - Display clauses with less.\n");
   printf("  togl <functor>/<arity> [0-based indexes] - Toggle clause(s).\n");
+  printf("  gc - Display garbage collection statistics.\n");
   printf("  <one line of Prolog text> - Run Prolog.\n");
   printf("\n");
+  printf("Environment variables:\n");
+  printf("  PROLOG_GC_WATERMARK=<0-100> (default 75)\n");
+  printf("     Collect the heap when it is this percent full.\n");
+  printf("  PROLOG_GC_VERBOSE\n");
+  printf("     If set, report each collection to stderr.\n");
+  printf("  PROLOG_LINK_VERBOSE\n");
+  printf("     If set, report each link to stderr.\n");
+  printf("\n");
 }
 
 // expand file names with ls
@@ -88,29 +115,67 @@ static set<string> expand_args(int fst) {
   return ans;
 }
 
-// compile and run Prolog
-static void run(const char* mode, const char* in) {
-  int pd[2];
-  pipe(pd);
-  int rd=pd[0],wd=pd[1];
-  pid_t pid = fork();
-  if (!pid) {
-    close(rd); // child won't read from pipe
-    dup2(wd,1); // child will write to pipe, via stdout (1)
-    execl(a0,a0,mode,in,(char*)0);
-  }
-  close(wd); // parent won't write to pipe
-  FILE* fp = fdopen(rd,"r");
-  machine_run(fp);
+// compile and run Prolog. the compiler runs in this process and hands
+// each line of code straight to the machine
+static void assemble(const code_line* L, void*) { machine_assemble(*L); }
+static void run(const string& line) {
+  compile(line.c_str(),assemble,nullptr);
+  machine_run();
+}
+
+// binary object of a Prolog file, if it is newer than the file
+static bool fresh_object(const string& fn) {
+  struct stat src, obj;
+  if (stat(fn.c_str(),&src) || stat((fn+".wam").c_str(),&obj)) return false;
+  return src.st_mtime < obj.st_mtime;
+}
+
+// compile a Prolog file to a .wam object. the code is assembled here and
+// written out instead of run
+static int compile_object(const string& fn) {
+  int st = compile_file(fn.c_str(),assemble,nullptr);
+  FILE* fp = fopen((fn+".wam").c_str(),"w");
+  if (!fp) fprintf(stderr,"%s.wam: cannot open file\n",fn.c_str());
+  machine_write_object(fp); // drops the code even if it cannot be written
+  if (!fp) return 1;
   fclose(fp);
-  waitpid(pid,nullptr,0);
+  if (st == 1) remove((fn+".wam").c_str());
+  return st;
+}
+
+// compile a set of Prolog files to objects, each in a child process, with at
+// most jobs of them at once. the status is the sum of the files' statuses
+static int compile_objects(const set<string>& fns, size_t jobs) {
+  map<pid_t,string> running;
+  int st = 0;
+  auto reap = [&]() {
+    int ws;
+    pid_t pid = waitpid(-1,&ws,0);
+    if (pid < 0) return;
+    if (WIFEXITED(ws)) st += WEXITSTATUS(ws);
+    else st++, remove((running[pid]+".wam").c_str()); // worker crashed
+    running.erase(pid);
+  };
+  for (auto& fn : fns) {
+    while (running.size() >= jobs) reap();
+    fflush(nullptr); // or the children flush it again
+    pid_t pid = fork();
+    if (!pid) exit(compile_object(fn));
+    if (pid < 0) st += compile_object(fn); // no worker, compile it here
+    else running[pid] = fn;
+  }
+  while (!running.empty()) reap();
+  return st;
 }
 
 // load set of Prolog files
 static void load(const set<string>& fns) {
   static set<string> files;
   for (auto& fn : fns) if (!files.count(fn)) {
-    run("-c",fn.c_str());
+    if (!fresh_object(fn) || machine_load_object((fn+".wam").c_str()) < 1) {
+      compile_file(fn.c_str(),assemble,nullptr);
+    }
+    machine_run();
     files.insert(fn);
   }
 }
@@ -180,6 +245,7 @@ static void togl(istream& in) {
       else printf("procedure %s[%d] not defined.\n",f.c_str(),i);
     }
     if (cnt == 0) for (auto& cl : clauses) cl.on = !cl.on;
+    machine_relink(f);
   }
 }
 
@@ -194,7 +260,8 @@ static int shell(const string& line, string& name, bool& quit) {
   else if (cmd == "more") more(ss);
   else if (cmd == "less") less_(ss);
   else if (cmd == "togl") togl(ss);
-  else run("-a",line.c_str());
+  else if (cmd == "gc") machine_gc_statistics();
+  else run(line);
   return 0;
 }
 
@@ -226,40 +293,74 @@ static int prompt(string name, function<int(const string&, string&, bool&)> f) {
   return status;
 }
 
+// memory size in bytes, with an optional K, M or G suffix
+static int64_t size_arg(const char* s) {
+  char* end;
+  int64_t n = strtoll(s,&end,10);
+  switch (toupper(*end)) {
+    case 'G': n <<= 10; // fall through
+    case 'M': n <<= 10; // fall through
+    case 'K': n <<= 10;
+  }
+  return n;
+}
+static int64_t size_env(const char* var, int64_t dflt) {
+  const char* s = getenv(var);
+  return s ? size_arg(s) : dflt;
+}
+
 int main(int argc, char** argv) {
-  // init args
+  // init args. memory and job options come first
   a0 = argv[0];
-  for (int i = 0; i < argc; i++) arg.push_back(argv[i]);
-  string arg1; if (argc > 1) arg1 = argv[1];
+  int64_t heap = size_env("PROLOG_HEAP",128<<20);
+  int64_t stack = size_env("PROLOG_STACK",32<<20);
+  int64_t trail = size_env("PROLOG_TRAIL",16<<20);
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  arg.push_back(argv[0]);
+  int fst = 1;
+  for (; fst+1 < argc && strlen(argv[fst]) == 2; fst += 2) {
+    char opt = argv[fst][1];
+    if (argv[fst][0] != '-') break;
+    else if (opt == 'H') heap = size_arg(argv[fst+1]);
+    else if (opt == 'S') stack = size_arg(argv[fst+1]);
+    else if (opt == 'T') trail = size_arg(argv[fst+1]);
+    else if (opt == 'j') jobs = atol(argv[fst+1]);
+    else break;
+  }
+  for (int i = fst; i < argc; i++) arg.push_back(argv[i]);
+  jobs = max(jobs,1L);
+  argc = arg.size();
+  string arg1; if (argc > 1) arg1 = arg[1];
+  machine_memory(heap,stack,trail);
+  const char* gc = getenv("PROLOG_GC_WATERMARK");
+  machine_gc(gc ? atoi(gc) : 75,getenv("PROLOG_GC_VERBOSE"));
+  machine_link(getenv("PROLOG_LINK_VERBOSE"));
   // help
   if (argc > 1 && arg1 == "-h") { usage(); return 0; }
   // compile command line Prolog text
-  if (argc > 2 && arg1 == "-a") return compile(argv[2]);
-  // compile set of files
-  if (argc > 2 && arg1 == "-c") {
-    auto fns = expand_args(2);
-    if (fns.size() == 1) return compile_file(fns.begin()->c_str());
+  if (argc > 2 && arg1 == "-a") {
+    return compile(arg[2].c_str(),print_line,stdout);
+  }
+  // compile set of files to objects
+  if (argc > 2 && arg1 == "-c") return compile_objects(expand_args(2),jobs);
+  // print the assembly of a set of files
+  if (argc > 2 && arg1 == "-l") {
     int st = 0;
-    for (auto& fn : fns) {
-      pid_t pid = fork();
-      if (!pid) {
-        freopen((fn+".wam").c_str(),"w",stdout);
-        execl(a0,a0,"-c",fn.c_str(),(char*)0);
-      }
-      int s;
-      waitpid(pid,&s,0);
-      s = WEXITSTATUS(s);
-      if (s == 1) remove((fn+".wam").c_str());
-      st += s;
+    for (auto& fn : expand_args(2)) {
+      st += compile_file(fn.c_str(),print_line,stdout);
     }
     return st;
   }
   // interpret set of files
   if (argc > 2 && arg1 == "-i") {
     for (auto& fn : expand_args(2)) {
-      FILE* fp = fopen(fn.c_str(),"r");
-      machine_run(fp);
-      fclose(fp);
+      int obj = machine_load_object(fn.c_str());
+      if (obj) machine_run();
+      else {
+        FILE* fp = fopen(fn.c_str(),"r");
+        machine_run(fp);
+        fclose(fp);
+      }
     }
     machine_close();
     return 0;
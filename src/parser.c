@@ -1,20 +1,17 @@
-#define PARSER_IMPL_H
+#include <string.h>
+
 #include "parser.h"
 
 #include "syntax.h"
 
-const char* parser_fn;
-int parser_error_flag;
-int parser_ln, parser_cl, parser_cln, parser_ccl;
-vector_t parser_st;
-
-void parser_init() {
-  parser_error_flag = 0;
-  parser_ln = 1, parser_cl = 1;
-  vinit(parser_st);
-  syntax_create_node(); // root = 0
+void parser_init(compiler_t* ctx, const char* fn) {
+  memset(ctx,0,sizeof(*ctx));
+  ctx->fn = fn;
+  ctx->ln = 1, ctx->cl = 1;
+  vinit(ctx->st);
+  syntax_create_node(ctx); // root = 0
 }
 
-void parser_close() {
-  syntax_free_tree(parser_st);
+void parser_close(compiler_t* ctx) {
+  syntax_free_tree(ctx->st);
 }
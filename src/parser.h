@@ -1,16 +1,33 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "code.h"
+#include "symbol.h"
 #include "vector.h"
 
-#ifndef PARSER_IMPL_H
-extern const char* parser_fn;
-extern int parser_error_flag;
-extern int parser_ln, parser_cl, parser_cln, parser_ccl;
-extern vector_t parser_st;
-#endif
+// state of one compilation. the scanner, the parser and the code generator
+// keep everything here, so compilations can run on several threads
+struct compiler {
+  // front end
+  const char* fn;
+  int error_flag;
+  int ln, cl;    // scanner position
+  int cln, ccl;  // where the open multiline comment began
+  int tln, tcl;  // where the last token began, for syntax errors
+  void* scanner; // flex yyscan_t
+  vector_t st;   // syntax tree, root = 0
+  // code generation
+  code_sink sink;
+  void* sink_data;
+  char* line; // output line being built
+  int line_n, line_c;
+  vector_t clause_code;
+  int nxtreg;
+  symbol_table_t prmvar, tmpvar;
+  vector_t prmreg, prmlst; // Y register and last goal of each prmvar
+};
 
-void parser_init();
-void parser_close();
+void parser_init(compiler_t*, const char* fn);
+void parser_close(compiler_t*);
 
 #endif
@@ -1,18 +1,32 @@
 
+%code requires {
+
+#include "parser.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+}
+
 %{
 
 #include <stdio.h>
 
 #include "syntax.h"
-#include "parser.h"
+
+%}
+
+%code {
 
 // flex stuff
-int yylex();
+int yylex(YYSTYPE*, yyscan_t);
 
 // bison stuff
-static void yyerror(const char*);
+static void yyerror(yyscan_t, compiler_t*, const char*);
 
-%}
+}
 
 %union {
   int u;
@@ -36,12 +50,19 @@ static void yyerror(const char*);
 %type <u> arith_add
 %type <u> arith_mul
 %type <u> arith_op
+%type <u> list
 
 %token <tok> SMALLATOM
 %token <tok> VARIABLE
 %token <tok> NUMERAL
 %token <tok> STRING
+%token <tok> IS
+%token <tok> COMPARE
+%token <tok> NIL
 
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {compiler_t* ctx}
 %define parse.lac full
 %define parse.error verbose
 
@@ -49,43 +70,43 @@ static void yyerror(const char*);
 
 program:
   clause_list query {
-    syntax_push_child(0,$1);
-    syntax_push_child(0,$2);
+    syntax_push_child(ctx,0,$1);
+    syntax_push_child(ctx,0,$2);
   }
   | clause_list {
-    syntax_push_child(0,$1);
-    syntax_push_child(0,syntax_create_node());
+    syntax_push_child(ctx,0,$1);
+    syntax_push_child(ctx,0,syntax_create_node(ctx));
   }
   | query {
-    syntax_push_child(0,syntax_create_node());
-    syntax_push_child(0,$1);
+    syntax_push_child(ctx,0,syntax_create_node(ctx));
+    syntax_push_child(ctx,0,$1);
   }
   | %empty {
-    syntax_push_child(0,syntax_create_node());
-    syntax_push_child(0,syntax_create_node());
+    syntax_push_child(ctx,0,syntax_create_node(ctx));
+    syntax_push_child(ctx,0,syntax_create_node(ctx));
   }
   ;
 
 clause_list:
   clause_list clause {
     $$ = $1;
-    syntax_push_child($$,$2);
+    syntax_push_child(ctx,$$,$2);
   }
   | clause {
-    $$ = syntax_create_node();
-    syntax_push_child($$,$1);
+    $$ = syntax_create_node(ctx);
+    syntax_push_child(ctx,$$,$1);
   }
   ;
 
 clause:
   predicate '.' {
     $$ = $1;
-    vat(node,parser_st,$$).type = N_FACT;
+    vat(node,ctx->st,$$).type = N_FACT;
   }
   | predicate ':' predicate_list '.' {
-    $$ = syntax_typed_node(N_RULE);
-    syntax_push_child($$,$1);
-    syntax_push_child($$,$3);
+    $$ = syntax_typed_node(ctx,N_RULE);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   | error '.' {
     $$ = -1;
@@ -96,73 +117,96 @@ clause:
 predicate:
   structure {
     $$ = $1;
-    vat(node,parser_st,$$).type = N_PREDICATE;
+    vat(node,ctx->st,$$).type = N_PREDICATE;
   }
   | arith_expr arith_add arith_term {
     $$ = $2;
-    syntax_push_child($$,$1);
-    syntax_push_child($$,$3);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   ;
 
 structure:
   atom {
-    $$ = syntax_typed_node(N_STRUCTURE);
-    syntax_push_child($$,$1);
-    syntax_push_child($$,syntax_create_node());
+    $$ = syntax_typed_node(ctx,N_STRUCTURE);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,syntax_create_node(ctx));
   }
   | atom '(' term_list ')' {
-    $$ = syntax_typed_node(N_STRUCTURE);
-    syntax_push_child($$,$1);
-    syntax_push_child($$,$3);
+    $$ = syntax_typed_node(ctx,N_STRUCTURE);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   ;
 
 atom:
   SMALLATOM {
-    $$ = syntax_token_node(N_ATOM,$1);
+    $$ = syntax_token_node(ctx,N_ATOM,$1);
   }
   | NUMERAL {
-    $$ = syntax_token_node(N_ATOM,$1);
+    $$ = syntax_token_node(ctx,N_NUMBER,$1);
   }
   | STRING {
-    $$ = syntax_token_node(N_ATOM,$1);
+    $$ = syntax_token_node(ctx,N_ATOM,$1);
+  }
+  | NIL {
+    $$ = syntax_token_node(ctx,N_ATOM,$1);
   }
   ;
 
 term_list:
   term_list ',' term {
     $$ = $1;
-    syntax_push_child($$,$3);
+    syntax_push_child(ctx,$$,$3);
   }
   | term {
-    $$ = syntax_create_node();
-    syntax_push_child($$,$1);
+    $$ = syntax_create_node(ctx);
+    syntax_push_child(ctx,$$,$1);
   }
   ;
 
 term:
   arith_expr
   | '_' {
-    $$ = syntax_typed_node(N_DONTCARE);
+    $$ = syntax_typed_node(ctx,N_DONTCARE);
+  }
+  | list
+  ;
+
+list:
+  '[' term_list ']' {
+    $$ = syntax_list_node(ctx,$2,-1);
+  }
+  | '[' term_list '|' term ']' {
+    $$ = syntax_list_node(ctx,$2,$4);
   }
   ;
 
 predicate_list:
   predicate_list ',' predicate_list_item {
     $$ = $1;
-    syntax_push_child($$,$3);
+    syntax_push_child(ctx,$$,$3);
   }
   | predicate_list_item {
-    $$ = syntax_create_node();
-    syntax_push_child($$,$1);
+    $$ = syntax_create_node(ctx);
+    syntax_push_child(ctx,$$,$1);
   }
   ;
 
 predicate_list_item:
   predicate
   | '!' {
-    $$ = syntax_typed_node(N_CUT);
+    $$ = syntax_typed_node(ctx,N_CUT);
+  }
+  | arith_expr IS arith_expr {
+    $$ = syntax_typed_node(ctx,N_IS);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
+  }
+  | arith_expr COMPARE arith_expr {
+    $$ = syntax_token_node(ctx,N_COMPARE,$2);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   ;
 
@@ -175,8 +219,8 @@ query:
 arith_expr:
   arith_expr arith_add arith_term {
     $$ = $2;
-    syntax_push_child($$,$1);
-    syntax_push_child($$,$3);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   | arith_term
   ;
@@ -184,8 +228,8 @@ arith_expr:
 arith_term:
   arith_term arith_mul arith_fact {
     $$ = $2;
-    syntax_push_child($$,$1);
-    syntax_push_child($$,$3);
+    syntax_push_child(ctx,$$,$1);
+    syntax_push_child(ctx,$$,$3);
   }
   | arith_fact
   ;
@@ -199,32 +243,33 @@ arith_fact:
 
 arith_add:
   '+' {
-    $$ = syntax_typed_node(N_ADD);
+    $$ = syntax_typed_node(ctx,N_ADD);
   }
   | '-' {
-    $$ = syntax_typed_node(N_SUB);
+    $$ = syntax_typed_node(ctx,N_SUB);
   }
   ;
 
 arith_mul:
   '*' {
-    $$ = syntax_typed_node(N_MUL);
+    $$ = syntax_typed_node(ctx,N_MUL);
   }
   | '/' {
-    $$ = syntax_typed_node(N_DIV);
+    $$ = syntax_typed_node(ctx,N_DIV);
   }
   ;
 
 arith_op:
   structure
   | VARIABLE {
-    $$ = syntax_token_node(N_VARIABLE,$1);
+    $$ = syntax_token_node(ctx,N_VARIABLE,$1);
   }
   ;
 
 %%
 
-static void yyerror(const char* s) {
-  parser_error_flag = 1;
-  fprintf(stderr,"%s:%d:%d: %s\n",parser_fn,yylval.tok.ln,yylval.tok.cl,s);
+static void yyerror(yyscan_t scanner, compiler_t* ctx, const char* s) {
+  (void)scanner;
+  ctx->error_flag = 1;
+  fprintf(stderr,"%s:%d:%d: %s\n",ctx->fn,ctx->tln,ctx->tcl,s);
 }
@@ -14,25 +14,43 @@ void syntax_free_tree(vector_t tree) {
   vdelete(tree);
 }
 
-int syntax_create_node() {
-  return syntax_typed_node(N_NOTYPE);
+int syntax_create_node(compiler_t* ctx) {
+  return syntax_typed_node(ctx,N_NOTYPE);
 }
 
-int syntax_typed_node(int type) {
-  return syntax_token_node(type,lexical_create_token(0,0));
+int syntax_typed_node(compiler_t* ctx, int type) {
+  return syntax_token_node(ctx,type,lexical_create_token(0,0));
 }
 
-int syntax_token_node(int type, token_t tok) {
-  int u = parser_st.n;
+int syntax_token_node(compiler_t* ctx, int type, token_t tok) {
+  int u = ctx->st.n;
   node nd;
   nd.type = type;
   nd.tok = tok;
   nd.val = 0;
   vinit(nd.v);
-  vpush(node,parser_st,nd);
+  vpush(node,ctx->st,nd);
   return u;
 }
 
-void syntax_push_child(int u, int v) {
-  vpush(int,vat(node,parser_st,u).v,v);
+void syntax_push_child(compiler_t* ctx, int u, int v) {
+  vpush(int,vat(node,ctx->st,u).v,v);
+}
+
+// the N_LIST chain of the terms of items, ending in tail ([] if tail < 0)
+int syntax_list_node(compiler_t* ctx, int items, int tail) {
+  if (tail < 0) {
+    token_t tok = lexical_create_token(0,0);
+    tok.data = strdup("[]");
+    tail = syntax_typed_node(ctx,N_STRUCTURE);
+    syntax_push_child(ctx,tail,syntax_token_node(ctx,N_ATOM,tok));
+    syntax_push_child(ctx,tail,syntax_create_node(ctx));
+  }
+  for (int i = vat(node,ctx->st,items).v.n-1; 0 <= i; i--) {
+    int u = syntax_typed_node(ctx,N_LIST);
+    syntax_push_child(ctx,u,vat(int,vat(node,ctx->st,items).v,i));
+    syntax_push_child(ctx,u,tail);
+    tail = u;
+  }
+  return tail;
 }
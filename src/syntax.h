@@ -1,6 +1,7 @@
 #ifndef SYNTAX_H
 #define SYNTAX_H
 
+#include "code.h"
 #include "vector.h"
 #include "lexical.h"
 
@@ -9,9 +10,10 @@ enum {
   // internal nodes
   NBEGIN_INTERNAL,
     N_FACT, // same as N_STRUCUTRE
-    N_RULE, // left: N_PREDICATE; right: {N_PREDICATE,N_CUT}+
+    N_RULE, // left: N_PREDICATE; right: {N_PREDICATE,N_CUT,N_IS,N_COMPARE}+
     N_PREDICATE, // same as N_STRUCUTRE
-    N_STRUCTURE, // left: N_ATOM; right: {N_STRUCTURE,TERMS}*
+    N_STRUCTURE, // left: N_ATOM or N_NUMBER; right: {N_STRUCTURE,TERMS}*
+    N_LIST, // left: head term; right: tail term
     // arithmetic operators
     NBEGIN_ARITH,
       N_ADD,
@@ -19,10 +21,14 @@ enum {
       N_MUL,
       N_DIV,
     NEND_ARITH,
+    // arithmetic goals. left and right: arithmetic expressions
+    N_IS,
+    N_COMPARE,  // COMPARE token
   NEND_INTERNAL,
   // leaves
   NBEGIN_LEAF,
-    N_ATOM,       // SMALLATOM, NUMERAL and STRING tokens
+    N_ATOM,       // SMALLATOM, STRING and NIL tokens
+    N_NUMBER,     // NUMERAL token: integer or float
     // TERMS
     NBEGIN_TERM,
       N_VARIABLE, // VARIABLE token
@@ -40,9 +46,11 @@ typedef struct {
 
 void syntax_free_tree(vector_t tree);
 
-int syntax_create_node();
-int syntax_typed_node(int type);
-int syntax_token_node(int type, token_t tok);
-void syntax_push_child(int u, int v);
+// nodes are added to the syntax tree of the compiler
+int syntax_create_node(compiler_t*);
+int syntax_typed_node(compiler_t*, int type);
+int syntax_token_node(compiler_t*, int type, token_t tok);
+void syntax_push_child(compiler_t*, int u, int v);
+int syntax_list_node(compiler_t*, int items, int tail);
 
 #endif
@@ -0,0 +1,22 @@
+#!/bin/sh
+# a shell query against a large loaded program must relink only its own
+# code, not the procedures of the program. usage: test/link.sh [prolog]
+prolog=${1:-./prolog}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+awk 'BEGIN {
+  for (p = 0; p < 1000; p++) for (i = 0; i < 100; i++) {
+    printf "p%d(%d, x%d).\n", p, i, i
+  }
+}' > "$dir/big.prolog"
+printf '?- p7(42, X)\n?- p7(42, X)\nexit\n' |
+  PROLOG_LINK_VERBOSE=1 "$prolog" "$dir/big.prolog" > "$dir/out" 2>&1
+grep -q 'X = x42' "$dir/out" || { echo "link.sh: wrong answer"; exit 1; }
+# the load links every procedure, and the queries none
+grep '^link:' "$dir/out" | sed 1d > "$dir/links"
+[ $(wc -l < "$dir/links") -eq 2 ] || { echo "link.sh: no link report"; exit 1; }
+grep -v '^link: 0 procedure(s)' "$dir/links" && {
+  echo "link.sh: a query relinked the program"
+  exit 1
+}
+echo "link.sh: ok"